@@ -0,0 +1,87 @@
+#pragma once
+#include "framework.h"
+#include "BloomDownCS.h"
+#include "BloomUpCS.h"
+#include "GpuTimer.h"
+
+// Dual-filter bloom. The down chain starts at half resolution with the threshold applied,
+// the up chain walks back adding every level, and the post shader samples up level 0 once.
+struct Bloom {
+	static constexpr int MAX_LEVELS = 6;
+
+	GLuint down = 0;    // RGBA16F, one mip per level
+	GLuint up = 0;      // RGBA16F, levels 0 .. levels - 2 are written
+	int levels = 0;
+	int width[MAX_LEVELS] = {}, height[MAX_LEVELS] = {};
+	int screenW = 0, screenH = 0;
+
+	BloomDownCS* downCS = nullptr;
+	BloomUpCS* upCS = nullptr;
+	GpuTimer downTimer, upTimer;
+
+	void create(int w, int h) {
+		destroy();
+		screenW = w; screenH = h;
+
+		// GL mip sizes from half resolution, stopping before a level gets smaller than one workgroup
+		width[0] = max(1, (w + 1) / 2);
+		height[0] = max(1, (h + 1) / 2);
+		levels = 1;
+		while (levels < MAX_LEVELS && (width[0] >> levels) >= 8 && (height[0] >> levels) >= 8) {
+			width[levels] = width[0] >> levels;
+			height[levels] = height[0] >> levels;
+			levels++;
+		}
+
+		down = createChain();
+		up = createChain();
+
+		downCS = new BloomDownCS();
+		upCS = new BloomUpCS();
+		downTimer.init();
+		upTimer.init();
+	}
+
+	void run(GLuint sceneColor, float threshold, float softKnee) {
+		downTimer.begin();
+		for (int level = 0; level < levels; level++) {
+			int srcW = level == 0 ? screenW : width[level - 1];
+			int srcH = level == 0 ? screenH : height[level - 1];
+			downCS->Dispatch(sceneColor, down, level, srcW, srcH, width[level], height[level], threshold, softKnee);
+		}
+		downTimer.end();
+
+		upTimer.begin();
+		for (int level = levels - 2; level >= 0; level--) {
+			GLuint src = level == levels - 2 ? down : up;
+			upCS->Dispatch(src, level + 1, down, up, level, width[level + 1], height[level + 1], width[level], height[level]);
+		}
+		upTimer.end();
+	}
+
+	// Sum of all levels at half resolution
+	GLuint result() const { return levels > 1 ? up : down; }
+
+	void destroy() {
+		if (down) { glDeleteTextures(1, &down); down = 0; }
+		if (up) { glDeleteTextures(1, &up); up = 0; }
+		if (downCS) { delete downCS; downCS = nullptr; }
+		if (upCS) { delete upCS; upCS = nullptr; }
+		downTimer.destroy();
+		upTimer.destroy();
+		levels = 0;
+	}
+
+private:
+	GLuint createChain() {
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA16F, width[0], height[0]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return tex;
+	}
+};
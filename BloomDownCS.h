@@ -0,0 +1,34 @@
+#pragma once
+#include "computeshader.h"
+
+class BloomDownCS : public ComputeShader {
+public:
+    BloomDownCS() {
+        create("bloom_down.comp");
+    }
+
+    // level 0 thresholds sceneColor into chain level 0, later levels read chain level - 1
+    void Dispatch(GLuint sceneColor, GLuint chain, int level, int srcW, int srcH, int dstW, int dstH, float threshold, float softKnee) {
+        glUseProgram(getId());
+
+        setUniform(level == 0 ? 1 : 0, "u_prefilter");
+        setIVec2(srcW, srcH, "u_srcSize");
+        setIVec2(dstW, dstH, "u_dstSize");
+        setUniform(threshold, "u_threshold");
+        setUniform(softKnee, "u_softKnee");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sceneColor);
+        if (level > 0) glBindImageTexture(0, chain, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+        glBindImageTexture(1, chain, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        glDispatchCompute((dstW + 7) / 8, (dstH + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
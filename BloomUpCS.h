@@ -0,0 +1,30 @@
+#pragma once
+#include "computeshader.h"
+
+class BloomUpCS : public ComputeShader {
+public:
+    BloomUpCS() {
+        create("bloom_up.comp");
+    }
+
+    // dst level = upsample(src level + 1) + down level
+    void Dispatch(GLuint src, int srcLevel, GLuint down, GLuint dst, int level, int srcW, int srcH, int dstW, int dstH) {
+        glUseProgram(getId());
+
+        setIVec2(srcW, srcH, "u_srcSize");
+        setIVec2(dstW, dstH, "u_dstSize");
+
+        glBindImageTexture(0, src, srcLevel, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+        glBindImageTexture(1, down, level, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA16F);
+        glBindImageTexture(2, dst, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        glDispatchCompute((dstW + 7) / 8, (dstH + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "computeshader.h"
+
+class ChunkCullCS : public ComputeShader {
+public:
+    ChunkCullCS() {
+        create("chunk_cull.comp");
+    }
+
+    // One workgroup per chunk slot; buffers and the Hi-Z texture are bound by the caller
+    void Dispatch(int slotCount) {
+        glDispatchCompute(slotCount, 1, 1);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+
+    void setVec4Array(const vec4* v, int count, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform4fv(location, count, &v[0].x);
+    }
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <xmmintrin.h>
+#include "framework.h"
+#include "camera.h"
+
+// CPU frustum culling for the chunk grid around the camera.
+// Chunk bounds live in SoA arrays, four chunks (a 2x2 block) per SSE test. A quadtree over the blocks
+// rejects or accepts whole regions first, so the cost follows the visible area rather than the grid size.
+class ChunkVisibility {
+	int side = 0;       // cells per grid edge, 2 * renderDist + 1
+	int dim = 0;        // side rounded up to a power of two
+	int leafLevel = 0;  // quadtree level whose nodes are 2x2 blocks; level 0 is the root
+
+	// Per cell, block-major: block b owns [4b, 4b + 4), lane = (z & 1) * 2 + (x & 1)
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+	std::vector<int> handles;
+
+	// Per quadtree level: node bounds and whether anything below is occupied
+	std::vector<std::vector<AABB>> nodeBounds;
+	std::vector<std::vector<uint8_t>> nodeMask; // leaf level: occupied lanes of the block, above: 0/1
+	bool dirty = false;
+
+public:
+	int nodesTested = 0;  // last query
+	int boxesTested = 0;
+
+	void resize(int renderDist) {
+		side = 2 * renderDist + 1;
+		dim = 2;
+		while (dim < side) dim *= 2;
+
+		leafLevel = 0;
+		while ((1 << leafLevel) < dim / 2) leafLevel++;
+
+		const size_t cells = size_t(dim) * dim;
+		for (auto* v : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ }) v->assign(cells, 0.0f);
+		handles.assign(cells, -1);
+
+		nodeBounds.resize(leafLevel + 1);
+		nodeMask.resize(leafLevel + 1);
+		for (int level = 0; level <= leafLevel; level++) {
+			nodeBounds[level].assign(size_t(1) << (2 * level), AABB());
+			nodeMask[level].assign(size_t(1) << (2 * level), 0);
+		}
+		dirty = false;
+	}
+
+	void clear() {
+		handles.assign(handles.size(), -1);
+		for (auto& mask : nodeMask) mask.assign(mask.size(), 0);
+		dirty = false;
+	}
+
+	// x, z in [0, side): grid coordinates relative to the grid corner
+	void insert(int x, int z, const AABB& bounds, int handle) {
+		if (x < 0 || z < 0 || x >= side || z >= side) return;
+		int i = cellIndex(x, z);
+		minX[i] = bounds.min.x; minY[i] = bounds.min.y; minZ[i] = bounds.min.z;
+		maxX[i] = bounds.max.x; maxY[i] = bounds.max.y; maxZ[i] = bounds.max.z;
+		handles[i] = handle;
+		dirty = true;
+	}
+
+	void remove(int x, int z) {
+		if (x < 0 || z < 0 || x >= side || z >= side) return;
+		handles[cellIndex(x, z)] = -1;
+		dirty = true;
+	}
+
+	// Appends the handles of every chunk that may intersect the frustum
+	void query(const FrustumPlanes& planes, std::vector<int>& out) {
+		if (dirty) refit();
+		nodesTested = boxesTested = 0;
+		visit(0, 0, 0, false, planes, out);
+	}
+
+private:
+	int cellIndex(int x, int z) const {
+		int block = (z >> 1) * (dim >> 1) + (x >> 1);
+		return block * 4 + (z & 1) * 2 + (x & 1);
+	}
+
+	// Node bounds bottom-up; only runs after the grid changed
+	void refit() {
+		const int blocks = (dim / 2) * (dim / 2);
+		for (int b = 0; b < blocks; b++) {
+			uint8_t mask = 0;
+			AABB box;
+			for (int lane = 0; lane < 4; lane++) {
+				int i = b * 4 + lane;
+				if (handles[i] < 0) continue;
+				vec3 lo = vec3(minX[i], minY[i], minZ[i]);
+				vec3 hi = vec3(maxX[i], maxY[i], maxZ[i]);
+				box.min = mask ? minVec3(box.min, lo) : lo;
+				box.max = mask ? maxVec3(box.max, hi) : hi;
+				mask |= uint8_t(1 << lane);
+			}
+			nodeMask[leafLevel][b] = mask;
+			nodeBounds[leafLevel][b] = box;
+		}
+
+		for (int level = leafLevel - 1; level >= 0; level--) {
+			const int n = 1 << level;
+			for (int z = 0; z < n; z++) {
+				for (int x = 0; x < n; x++) {
+					uint8_t any = 0;
+					AABB box;
+					for (int c = 0; c < 4; c++) {
+						int child = (2 * z + (c >> 1)) * (2 * n) + 2 * x + (c & 1);
+						if (!nodeMask[level + 1][child]) continue;
+						const AABB& cb = nodeBounds[level + 1][child];
+						box.min = any ? minVec3(box.min, cb.min) : cb.min;
+						box.max = any ? maxVec3(box.max, cb.max) : cb.max;
+						any = 1;
+					}
+					nodeMask[level][z * n + x] = any;
+					nodeBounds[level][z * n + x] = box;
+				}
+			}
+		}
+		dirty = false;
+	}
+
+	// -1 outside, 0 intersecting, 1 fully inside
+	static int classify(const AABB& box, const FrustumPlanes& planes) {
+		int result = 1;
+		for (const vec4& p : planes) {
+			vec3 pv = vec3(p.x >= 0.0f ? box.max.x : box.min.x, p.y >= 0.0f ? box.max.y : box.min.y, p.z >= 0.0f ? box.max.z : box.min.z);
+			vec3 nv = vec3(p.x >= 0.0f ? box.min.x : box.max.x, p.y >= 0.0f ? box.min.y : box.max.y, p.z >= 0.0f ? box.min.z : box.max.z);
+			if (p.x * pv.x + p.y * pv.y + p.z * pv.z + p.w < 0.0f) return -1;
+			if (p.x * nv.x + p.y * nv.y + p.z * nv.z + p.w < 0.0f) result = 0;
+		}
+		return result;
+	}
+
+	// Lane mask of the block's boxes that are not outside any plane (p-vertex test, 4 boxes at once)
+	int testBlock(int block, const FrustumPlanes& planes) const {
+		const int i = block * 4;
+		const __m128 loX = _mm_loadu_ps(&minX[i]), loY = _mm_loadu_ps(&minY[i]), loZ = _mm_loadu_ps(&minZ[i]);
+		const __m128 hiX = _mm_loadu_ps(&maxX[i]), hiY = _mm_loadu_ps(&maxY[i]), hiZ = _mm_loadu_ps(&maxZ[i]);
+
+		__m128 outside = _mm_setzero_ps();
+		for (const vec4& p : planes) {
+			__m128 d = _mm_mul_ps(p.x >= 0.0f ? hiX : loX, _mm_set1_ps(p.x));
+			d = _mm_add_ps(d, _mm_mul_ps(p.y >= 0.0f ? hiY : loY, _mm_set1_ps(p.y)));
+			d = _mm_add_ps(d, _mm_mul_ps(p.z >= 0.0f ? hiZ : loZ, _mm_set1_ps(p.z)));
+			d = _mm_add_ps(d, _mm_set1_ps(p.w));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+		return ~_mm_movemask_ps(outside) & 0xF;
+	}
+
+	void visit(int level, int x, int z, bool inside, const FrustumPlanes& planes, std::vector<int>& out) {
+		const int node = z * (1 << level) + x;
+		const uint8_t mask = nodeMask[level][node];
+		if (!mask) return;
+
+		// Once a node is fully inside, nothing below it needs a test
+		if (!inside) {
+			nodesTested++;
+			int c = classify(nodeBounds[level][node], planes);
+			if (c < 0) return;
+			inside = c > 0;
+		}
+
+		if (level == leafLevel) {
+			int lanes = mask;
+			if (!inside) {
+				lanes &= testBlock(node, planes);
+				boxesTested += 4;
+			}
+			for (int lane = 0; lane < 4; lane++) {
+				if (lanes & (1 << lane)) out.push_back(handles[node * 4 + lane]);
+			}
+			return;
+		}
+
+		for (int c = 0; c < 4; c++) visit(level + 1, 2 * x + (c & 1), 2 * z + (c >> 1), inside, planes, out);
+	}
+};
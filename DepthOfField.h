@@ -0,0 +1,67 @@
+#pragma once
+#include "framework.h"
+#include "RenderState.h"
+#include "DofTilesCS.h"
+#include "DofGatherCS.h"
+#include "GpuTimer.h"
+
+// Tile-classified depth of field. A pre-pass finds the largest circle of confusion per 16x16 tile,
+// the gather only runs at half resolution around tiles that are out of focus, and the post shader
+// keeps the sharp scene for in-focus tiles.
+struct DepthOfField {
+	static constexpr int TILE_SIZE = 16;
+
+	GLuint tiles = 0;   // R16F, max CoC per tile
+	GLuint blur = 0;    // RGBA16F, half resolution
+	int tilesW = 0, tilesH = 0;
+	int halfW = 0, halfH = 0;
+	int screenW = 0, screenH = 0;
+
+	DofTilesCS* tilesCS = nullptr;
+	DofGatherCS* gatherCS = nullptr;
+	GpuTimer timer;
+
+	void create(int w, int h) {
+		destroy();
+		screenW = w; screenH = h;
+		tilesW = (w + TILE_SIZE - 1) / TILE_SIZE;
+		tilesH = (h + TILE_SIZE - 1) / TILE_SIZE;
+		halfW = max(1, (w + 1) / 2);
+		halfH = max(1, (h + 1) / 2);
+
+		tiles = createTexture(GL_R16F, tilesW, tilesH, GL_NEAREST);
+		blur = createTexture(GL_RGBA16F, halfW, halfH, GL_LINEAR);
+
+		tilesCS = new DofTilesCS();
+		gatherCS = new DofGatherCS();
+		timer.init();
+	}
+
+	void run(const RenderState& state, GLuint sceneColor, GLuint sceneDepth) {
+		timer.begin();
+		tilesCS->Dispatch(state, sceneDepth, tiles, screenW, screenH, TILE_SIZE);
+		gatherCS->Dispatch(state, sceneColor, sceneDepth, tiles, blur, screenW, screenH, halfW, halfH);
+		timer.end();
+	}
+
+	void destroy() {
+		if (tiles) { glDeleteTextures(1, &tiles); tiles = 0; }
+		if (blur) { glDeleteTextures(1, &blur); blur = 0; }
+		if (tilesCS) { delete tilesCS; tilesCS = nullptr; }
+		if (gatherCS) { delete gatherCS; gatherCS = nullptr; }
+		timer.destroy();
+	}
+
+private:
+	GLuint createTexture(GLenum format, int w, int h, GLint filter) {
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexStorage2D(GL_TEXTURE_2D, 1, format, w, h);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return tex;
+	}
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include "computeshader.h"
+#include "RenderState.h"
+
+class DofGatherCS : public ComputeShader {
+public:
+    DofGatherCS() {
+        create("dof_gather.comp");
+    }
+
+    // Blurs into the half-resolution target wherever a nearby tile is out of focus
+    void Dispatch(const RenderState& state, GLuint sceneColor, GLuint sceneDepth, GLuint tiles, GLuint dst, int width, int height, int halfW, int halfH) {
+        glUseProgram(getId());
+
+        setIVec2(width, height, "u_size");
+        setIVec2(halfW, halfH, "u_halfSize");
+        setUniform(state.nearPlane, "u_near");
+        setUniform(state.farPlane, "u_far");
+        setUniform(state.focusDist, "u_focusDist");
+        setUniform(state.focusRange, "u_focusRange");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, sceneColor);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, sceneDepth);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, tiles);
+        glBindImageTexture(0, dst, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        glDispatchCompute((halfW + 7) / 8, (halfH + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "computeshader.h"
+#include "RenderState.h"
+
+class DofTilesCS : public ComputeShader {
+public:
+    DofTilesCS() {
+        create("dof_tiles.comp");
+    }
+
+    // One workgroup per tile of tileSize x tileSize pixels
+    void Dispatch(const RenderState& state, GLuint sceneDepth, GLuint tiles, int width, int height, int tileSize) {
+        glUseProgram(getId());
+
+        setIVec2(width, height, "u_size");
+        setUniform(state.nearPlane, "u_near");
+        setUniform(state.farPlane, "u_far");
+        setUniform(state.focusDist, "u_focusDist");
+        setUniform(state.focusRange, "u_focusRange");
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, sceneDepth);
+        glBindImageTexture(0, tiles, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+
+        glDispatchCompute((width + tileSize - 1) / tileSize, (height + tileSize - 1) / tileSize, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "framework.h"
+
+// GL_TIME_ELAPSED around a pass. Results are read a few frames late so the CPU never waits on the GPU.
+// Only one timer may be running at a time (GL does not nest time-elapsed queries).
+struct GpuTimer {
+	static constexpr int LATENCY = 4;
+	GLuint queries[LATENCY] = {};
+	bool pending[LATENCY] = {};
+	int frame = 0;
+	float ms = 0.0f; // smoothed
+
+	void init() {
+		glGenQueries(LATENCY, queries);
+	}
+
+	void begin() {
+		int i = frame % LATENCY;
+		if (pending[i]) collect(i);
+		glBeginQuery(GL_TIME_ELAPSED, queries[i]);
+	}
+
+	void end() {
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[frame % LATENCY] = true;
+		frame++;
+	}
+
+	float getMs() const { return ms; }
+
+	void destroy() {
+		if (queries[0]) glDeleteQueries(LATENCY, queries);
+		for (int i = 0; i < LATENCY; i++) { queries[i] = 0; pending[i] = false; }
+	}
+
+private:
+	void collect(int i) {
+		pending[i] = false;
+
+		// Still in flight after LATENCY frames: drop the sample rather than stall
+		GLint available = 0;
+		glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) return;
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+		ms += (float(ns) * 1e-6f - ms) * 0.1f;
+	}
+};
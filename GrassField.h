@@ -4,8 +4,22 @@
 #include "framework.h"
 #include "grassshader.h"
 #include "GrassScatterCS.h"
+#include "InstanceBatch.h"
 #include "TrackManager.h"
 
+// Blades are bucketed into GRASS_TILE_SIDE^2 tiles per chunk so they can be culled in clusters
+constexpr int GRASS_TILE_SIDE = 4;
+constexpr int GRASS_TILES = GRASS_TILE_SIDE * GRASS_TILE_SIDE;
+
+// Matches the GrassOut header in grass_scatter.comp
+struct GrassHeader {
+    GLuint instanceCount;
+    GLuint _pad[3];
+    GLuint tileCount[GRASS_TILES];
+    GLuint tileMinY[GRASS_TILES]; // order-preserving float bits
+    GLuint tileMaxY[GRASS_TILES];
+};
+
 struct GrassInstance {
     vec3 pos;
     float yaw;
@@ -18,14 +32,24 @@ struct GrassInstance {
 class GrassField {
 public:
     GLuint vao = 0, bladeVBO = 0, instanceVBO = 0;
+    GLuint fullCommands = 0;      // every blade of every tile, for passes that are not culled
+    GLuint culledCommands = 0;    // per-tile commands written by the chunk cull pass
+    GLintptr culledOffset = 0;
     size_t instanceCount = 0;   // final instance count after compute shader
-    size_t capacity = 0;        // max attempts / capacity passed to compute shader
+    size_t capacity = 0;        // blade slots, GRASS_TILES * tileCapacity
+    GLuint tileCapacity = 0;    // blade slots per tile
+    GLuint tileCount[GRASS_TILES] = {};
+    float tileMinY[GRASS_TILES] = {}, tileMaxY[GRASS_TILES] = {}; // blade roots
     Shader* shader = new GrassShader();
     GrassScatterCS scatterCS;
 
 
     GrassField(size_t maxCount, vec3 chunkId, float chunkSize, int segIndexCount) {
-        capacity = maxCount;
+        // The scatter walks a side x side grid of candidates; a tile gets at most ceil(side / TILE_SIDE)^2 of them
+        GLuint side = (GLuint)ceil(sqrt((double)maxCount));
+        GLuint tileEdge = (side + GRASS_TILE_SIDE - 1) / GRASS_TILE_SIDE;
+        tileCapacity = tileEdge * tileEdge;
+        capacity = size_t(tileCapacity) * GRASS_TILES;
         
         // Base triangle
         const float bladeVerts[3 * 3] = {
@@ -50,23 +74,36 @@ public:
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceVBO);
 
         // Header + Payload
-        const GLsizeiptr headerSize = 16; // 4 uints = 16 bytes
+        const GLsizeiptr headerSize = sizeof(GrassHeader);
         const GLsizeiptr bufferSize = headerSize + GLsizeiptr(capacity) * sizeof(GrassInstance);
         glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
 
-        // Zero the atomic counter at offset 0
-        GLuint zero = 0;
-        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+        // Zero the counters, empty height ranges
+        GrassHeader header = {};
+        for (int t = 0; t < GRASS_TILES; t++) header.tileMinY[t] = 0xFFFFFFFFu;
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GrassHeader), &header);
 
         // Bind SSBO at binding = 1 for compute shader to write
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instanceVBO);
         
         // Dispatch
-        scatterCS.Dispatch((GLuint)capacity, chunkId, chunkSize, segIndexCount);
+        scatterCS.Dispatch((GLuint)maxCount, GRASS_TILE_SIDE, tileCapacity, chunkId, chunkSize, segIndexCount);
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
 
-        // Read back instanceCount
-        glGetNamedBufferSubData(instanceVBO, 0, sizeof(GLuint), &instanceCount);
+        // Read back the counts and per-tile height ranges
+        glGetNamedBufferSubData(instanceVBO, 0, sizeof(GrassHeader), &header);
+        instanceCount = header.instanceCount;
+        for (int t = 0; t < GRASS_TILES; t++) {
+            tileCount[t] = min(header.tileCount[t], tileCapacity);
+            tileMinY[t] = tileCount[t] ? orderedBitsToFloat(header.tileMinY[t]) : 0.0f;
+            tileMaxY[t] = tileCount[t] ? orderedBitsToFloat(header.tileMaxY[t]) : 0.0f;
+        }
+
+        DrawArraysIndirectCommand cmds[GRASS_TILES];
+        for (int t = 0; t < GRASS_TILES; t++) cmds[t] = { 3u, tileCount[t], 0u, GLuint(t) * tileCapacity };
+        glGenBuffers(1, &fullCommands);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, fullCommands);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(cmds), cmds, GL_STATIC_DRAW);
 
         // Vertex attributes
         glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
@@ -93,16 +130,26 @@ public:
         glVertexAttribDivisor(5, 1);
     }
 
+    // GRASS_TILES commands laid out like fullCommands, their instanceCounts filled by the cull pass
+    void SetCulledCommands(GLuint commandBuffer, GLintptr offset) {
+        culledCommands = commandBuffer;
+        culledOffset = offset;
+    }
+
+    // One command per tile (baseInstance = tile * tileCapacity)
     void Draw(RenderState& state) {
         shader->Bind(state);
         glBindVertexArray(vao);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, (GLsizei)instanceCount);
+        bool culled = culledCommands && !state.shadowPass;
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled ? culledCommands : fullCommands);
+        glMultiDrawArraysIndirect(GL_TRIANGLES, (void*)(culled ? culledOffset : 0), GRASS_TILES, 0);
     }
 
     void destroy() {
         if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
+        if (fullCommands) glDeleteBuffers(1, &fullCommands);
         if (bladeVBO)    glDeleteBuffers(1, &bladeVBO);
         if (vao)         glDeleteVertexArrays(1, &vao);
-        vao = bladeVBO = instanceVBO = 0;
+        vao = bladeVBO = instanceVBO = fullCommands = 0;
     }
 };
\ No newline at end of file
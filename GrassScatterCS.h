@@ -7,10 +7,12 @@ public:
         create("grass_scatter.comp");
     }
 
-    void Dispatch(int instanceCount, vec3 chunkId, float chunkSize, int segIndexCount) {
+    void Dispatch(int instanceCount, int tileSide, int tileCapacity, vec3 chunkId, float chunkSize, int segIndexCount) {
         glUseProgram(getId());
 
         setUniform(instanceCount, "u_instanceCount");
+        setUniform(tileSide, "u_tileSide");
+        setUniform(tileCapacity, "u_tileCapacity");
         setUniform(chunkId, "u_chunkId");
         setUniform(chunkSize, "u_chunkSize");
         setUniform(segIndexCount, "u_segIndexCount");
@@ -0,0 +1,51 @@
+#pragma once
+#include "framework.h"
+#include "HiZBuildCS.h"
+
+// Min/max depth pyramid of the previous frame, for occlusion tests.
+// Level 0 is half the screen resolution (rounded up); further levels follow the GL mip sizes down to 1x1.
+struct HiZBuffer {
+	GLuint texture = 0; // RG32F: nearest, farthest depth
+	int width = 0, height = 0, levels = 0;
+	mat4 viewProj;      // camera matrices the pyramid was built with
+	bool valid = false; // false until the first build
+	HiZBuildCS* buildCS = nullptr;
+
+	void create(int screenW, int screenH) {
+		destroy();
+		width = max(1, (screenW + 1) / 2);
+		height = max(1, (screenH + 1) / 2);
+		levels = 1;
+		for (int s = max(width, height); s > 1; s /= 2) levels++;
+
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexStorage2D(GL_TEXTURE_2D, levels, GL_RG32F, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		buildCS = new HiZBuildCS();
+	}
+
+	// depthTex: screenW x screenH depth texture of the frame rendered with VP
+	void build(GLuint depthTex, int screenW, int screenH, const mat4& VP) {
+		int srcW = screenW, srcH = screenH;
+		int dstW = width, dstH = height;
+		for (int level = 0; level < levels; level++) {
+			buildCS->Dispatch(depthTex, texture, level, srcW, srcH, dstW, dstH);
+			srcW = dstW; srcH = dstH;
+			dstW = max(1, dstW / 2);
+			dstH = max(1, dstH / 2);
+		}
+		viewProj = VP;
+		valid = true;
+	}
+
+	void destroy() {
+		if (texture) { glDeleteTextures(1, &texture); texture = 0; }
+		if (buildCS) { delete buildCS; buildCS = nullptr; }
+		valid = false;
+	}
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include "computeshader.h"
+
+class HiZBuildCS : public ComputeShader {
+public:
+    HiZBuildCS() {
+        create("hiz_build.comp");
+    }
+
+    // Reduce srcSize into level of hiZ (level 0 reads the depth texture on unit 0)
+    void Dispatch(GLuint depthTex, GLuint hiZ, int level, int srcW, int srcH, int dstW, int dstH) {
+        glUseProgram(getId());
+
+        setUniform(level, "u_level");
+        setIVec2(srcW, srcH, "u_srcSize");
+        setIVec2(dstW, dstH, "u_dstSize");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTex);
+        if (level > 0) glBindImageTexture(0, hiZ, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+        glBindImageTexture(1, hiZ, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+
+        glDispatchCompute((dstW + 7) / 8, (dstH + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include "framework.h"
+#include "geometry.h"
+#include "renderstate.h"
+#include "ImpostorBakeShader.h"
+
+// Startup-baked views of every tree variant for distant chunks.
+// Each variant gets one layer of a texture array holding FRAMES x FRAMES views taken from
+// hemi-octahedrally distributed directions over the upper hemisphere (trees are never seen from below).
+// Texels store the object-space normal and a material id so the palette can still change at runtime.
+struct ImpostorAtlas {
+	static constexpr int FRAMES = 8;
+	static constexpr int FRAME_RES = 128;
+	static constexpr int SIZE = FRAMES * FRAME_RES;
+
+	GLuint fbo = 0;
+	GLuint depthRbo = 0;
+	GLuint texture = 0;          // GL_TEXTURE_2D_ARRAY, one layer per variant
+	std::vector<vec4> bounds;    // object-space center.xyz, radius in .w
+
+	// Must match hemiOctDecode in impostorshader.vert
+	static vec3 hemiOctDecode(vec2 e) {
+		float x = (e.x + e.y) * 0.5f;
+		float z = (e.x - e.y) * 0.5f;
+		return normalize(vec3(x, 1.0f - fabsf(x) - fabsf(z), z));
+	}
+
+	void bake(const std::vector<Geometry*>& trunks, const std::vector<Geometry*>& crowns) {
+		const int layers = (int)min(trunks.size(), crowns.size());
+		if (layers == 0) return;
+
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, SIZE, SIZE, layers);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // material id must not blend
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenRenderbuffers(1, &depthRbo);
+		glBindRenderbuffer(GL_RENDERBUFFER, depthRbo);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SIZE, SIZE);
+
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRbo);
+
+		ImpostorBakeShader bakeShader;
+		RenderState state;
+
+		GLboolean blendWasOn = glIsEnabled(GL_BLEND);
+		glDisable(GL_BLEND); // alpha carries the material id
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+		bounds.resize(layers);
+		for (int layer = 0; layer < layers; layer++) {
+			glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, layer);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				printf("Impostor FBO not complete!\n");
+
+			glViewport(0, 0, SIZE, SIZE);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Bounding sphere of trunk + crown
+			const AABB& a = trunks[layer]->getBounds();
+			const AABB& b = crowns[layer]->getBounds();
+			vec3 lo = minVec3(a.min, b.min);
+			vec3 hi = maxVec3(a.max, b.max);
+			vec3 center = (lo + hi) * 0.5f;
+			float R = length(hi - lo) * 0.5f;
+			bounds[layer] = vec4(center.x, center.y, center.z, R);
+
+			mat4 P = Ortho(-R, R, -R, R, 0.5f * R, 3.5f * R);
+			for (int j = 0; j < FRAMES; j++) {
+				for (int i = 0; i < FRAMES; i++) {
+					vec2 e = vec2((i + 0.5f) / FRAMES, (j + 0.5f) / FRAMES) * 2.0f - vec2(1.0f, 1.0f);
+					vec3 dir = hemiOctDecode(e);
+
+					glViewport(i * FRAME_RES, j * FRAME_RES, FRAME_RES, FRAME_RES);
+					state.MVP = P * LookAt(center + dir * (2.0f * R), center, vec3(0.0f, 1.0f, 0.0f));
+					bakeShader.Bind(state);
+
+					bakeShader.setUniform(0.5f, "u_material");
+					trunks[layer]->Draw();
+					bakeShader.setUniform(1.0f, "u_material");
+					crowns[layer]->Draw();
+				}
+			}
+		}
+
+		if (blendWasOn) glEnable(GL_BLEND);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	void destroy() {
+		if (texture) { glDeleteTextures(1, &texture); texture = 0; }
+		if (depthRbo) { glDeleteRenderbuffers(1, &depthRbo); depthRbo = 0; }
+		if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; }
+	}
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include "framework.h"
+#include "shader.h"
+#include "renderstate.h"
+
+class ImpostorBakeShader : public Shader {
+
+public:
+	ImpostorBakeShader() {
+		create("impostorbake.vert", "impostorbake.frag", "fragmentColor");
+	}
+
+	void Bind(RenderState state) {
+		Use();
+
+		setUniform(state.MVP, "u_MVP");
+	}
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include "framework.h"
+#include "shader.h"
+#include "InstanceBatch.h"
+#include "ImpostorAtlas.h"
+
+// One camera-facing quad per instance, reading the same PackedInstance buffer as the full-detail batches
+class ImpostorBatch {
+    ImpostorAtlas* atlas = nullptr;
+    Shader* shader = nullptr;
+
+    GLuint vao = 0;
+    GLuint indirectBuffer = 0; // one 4-vertex strip command per variant
+
+    // Camera passes draw the survivors of the GPU cull instead, from shared buffers
+    GLuint culledVao = 0;
+    GLuint culledCommands = 0;
+    GLintptr culledOffset = 0;
+
+public:
+    ImpostorBatch(ImpostorAtlas* atlas, Shader* shader, GLuint instanceBuffer, GLuint countBuffer, GLuint capacityPerVariant)
+        : atlas(atlas), shader(shader) {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        bindInstanceAttribs(instanceBuffer);
+        glBindVertexArray(0);
+
+        std::vector<std::vector<DrawRange>> quads(atlas->bounds.size(), { { 4u, 0u, 0 } });
+        indirectBuffer = createIndirectCommands(quads, false, countBuffer, capacityPerVariant);
+    }
+
+    ~ImpostorBatch() {
+        if (vao) glDeleteVertexArrays(1, &vao);
+        if (culledVao) glDeleteVertexArrays(1, &culledVao);
+        if (indirectBuffer) glDeleteBuffers(1, &indirectBuffer);
+    }
+
+    // Same command layout as indirectBuffer at offset in commandBuffer, instances from visibleBuffer
+    void SetCulledSource(GLuint visibleBuffer, GLuint commandBuffer, GLintptr offset) {
+        if (!culledVao) glGenVertexArrays(1, &culledVao);
+        glBindVertexArray(culledVao);
+        bindInstanceAttribs(visibleBuffer);
+        glBindVertexArray(0);
+
+        culledCommands = commandBuffer;
+        culledOffset = offset;
+    }
+
+    void Draw(RenderState& state) {
+        shader->Bind(state);
+        shader->setUniform(ImpostorAtlas::FRAMES, "u_frames");
+
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, atlas->texture);
+
+        bool culled = culledCommands && !state.shadowPass;
+        glBindVertexArray(culled ? culledVao : vao);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled ? culledCommands : indirectBuffer);
+        for (size_t i = 0; i < atlas->bounds.size(); i++) {
+            shader->setUniform(atlas->bounds[i], "u_bounds");
+            shader->setUniform((int)i, "u_layer");
+            glDrawArraysIndirect(GL_TRIANGLE_STRIP, (void*)((culled ? culledOffset : 0) + i * sizeof(DrawArraysIndirectCommand)));
+        }
+    }
+
+    ImpostorBatch(const ImpostorBatch&) = delete;
+    ImpostorBatch& operator=(const ImpostorBatch&) = delete;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "framework.h"
+#include "shader.h"
+#include "renderstate.h"
+
+class ImpostorShader : public Shader {
+
+public:
+	ImpostorShader() {
+		create("impostorshader.vert", "impostorshader.frag", "fragmentColor");
+		createDepthOnly("impostorshader.vert", "impostordepth.frag");
+	}
+
+	void Bind(RenderState state) {
+		Use(state.depthOnly);
+
+		setUniform(state.cameraPos, "u_camPos_WS");
+		setUniform(state.V, "u_V");
+		setUniform(state.P, "u_P");
+		if (state.depthOnly) return;
+
+		// Shadow
+		setShadowUniforms(state);
+	}
+};
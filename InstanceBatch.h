@@ -3,6 +3,78 @@
 #include "geometry.h"
 #include "shader.h"
 
+// 16 bytes per instance: world position plus yaw and uniform scale as two halfs.
+// The vertex shader rebuilds Translate * RotateY(yaw) * Scale from it.
+struct PackedInstance {
+    vec3 pos;
+    uint32_t yawScale; // packHalf2x16(yaw, scale)
+
+    PackedInstance(vec3 pos = vec3(0.0f), float yaw = 0.0f, float scale = 1.0f) : pos(pos), yawScale(packHalf2x16(yaw, scale)) {}
+};
+
+// Matches the layout glDrawArraysIndirect reads
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+// Bind a PackedInstance buffer to attribs 1-2 of the currently bound VAO
+inline void bindInstanceAttribs(GLuint buffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    const GLsizei stride = sizeof(PackedInstance);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedInstance, pos));
+    glVertexAttribDivisor(1, 1);
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(PackedInstance, yawScale));
+    glVertexAttribDivisor(2, 1);
+}
+
+// Matches the layout glDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+inline GLsizeiptr indirectStride(bool indexed) {
+    return indexed ? sizeof(DrawElementsIndirectCommand) : sizeof(DrawArraysIndirectCommand);
+}
+
+// One indirect command per variant and LOD (variant-major): variant i starts at i * capacityPerVariant
+// and its instanceCount is copied GPU-side from countBuffer[i], so nothing is read back.
+inline GLuint createIndirectCommands(const std::vector<std::vector<DrawRange>>& rangesPerVariant, bool indexed, GLuint countBuffer, GLuint capacityPerVariant, GLuint buffer = 0) {
+    static_assert(offsetof(DrawArraysIndirectCommand, instanceCount) == offsetof(DrawElementsIndirectCommand, instanceCount), "instanceCount offset must match");
+
+    std::vector<DrawArraysIndirectCommand> arrayCmds;
+    std::vector<DrawElementsIndirectCommand> elementCmds;
+    std::vector<GLuint> cmdVariant;
+    for (size_t i = 0; i < rangesPerVariant.size(); i++) {
+        for (const DrawRange& r : rangesPerVariant[i]) {
+            if (indexed) elementCmds.push_back({ r.count, 0u, r.first, r.baseVertex, GLuint(i) * capacityPerVariant });
+            else         arrayCmds.push_back({ r.count, 0u, r.first, GLuint(i) * capacityPerVariant });
+            cmdVariant.push_back((GLuint)i);
+        }
+    }
+
+    if (!buffer) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    const void* data = indexed ? (const void*)elementCmds.data() : (const void*)arrayCmds.data();
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, cmdVariant.size() * indirectStride(indexed), data, GL_STATIC_DRAW);
+
+    for (size_t c = 0; c < cmdVariant.size(); c++) {
+        GLintptr dst = c * indirectStride(indexed) + offsetof(DrawArraysIndirectCommand, instanceCount);
+        glCopyNamedBufferSubData(countBuffer, buffer, cmdVariant[c] * sizeof(GLuint), dst, sizeof(GLuint));
+    }
+    return buffer;
+}
+
 class InstanceBatch {
     std::vector<Geometry*> geoms;
     Shader* shader = nullptr;
@@ -11,58 +83,126 @@ class InstanceBatch {
     std::vector<GLuint> instanceVBOs;
     std::vector<GLsizei> instanceCounts;
 
+    GLuint indirectBuffer = 0; // one command per variant and LOD when instances come from the GPU
+    std::vector<size_t> firstCommand; // per variant, into indirectBuffer
+    bool indexed = false;      // all variants of a batch share the same kind
+
+    // Camera passes draw the survivors of the GPU cull instead, from shared buffers
+    std::vector<GLuint> culledVaos;
+    GLuint culledCommands = 0;
+    GLintptr culledOffset = 0;
+
 public:
     InstanceBatch(std::vector<Geometry*> geomList, Shader* shader) : geoms(geomList), shader(shader) {
         const size_t N = geoms.size();
+        indexed = N > 0 && geoms[0]->isIndexed();
         vaos.resize(N, 0);
         instanceVBOs.resize(N, 0);
         instanceCounts.resize(N, 0);
 
         for (size_t i = 0; i < N; i++) {
             glGenVertexArrays(1, &vaos[i]);
-            glGenBuffers(1, &instanceVBOs[i]);
-
             glBindVertexArray(vaos[i]);
 
             // Bind GEOMETRY vertex buffer to attrib 0
             glBindBuffer(GL_ARRAY_BUFFER, geoms[i]->getVBO());
             glEnableVertexAttribArray(0);
             glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
-
-            // Bind INSTANCE buffer to attribs 1-4
-            glBindBuffer(GL_ARRAY_BUFFER, instanceVBOs[i]);
-            const GLuint baseLoc = 1;
-            for (int i = 0; i < 4; i++) {
-                glEnableVertexAttribArray(baseLoc + i);
-                glVertexAttribPointer(baseLoc + i, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), (void*)(sizeof(vec4) * i));
-                glVertexAttribDivisor(baseLoc + i, 1);
-            }
+            if (indexed) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geoms[i]->getEBO());
         }
-
+        glBindVertexArray(0);
     }
     ~InstanceBatch() {
         for (auto vao : vaos) if (vao) glDeleteVertexArrays(1, &vao);
+        for (auto vao : culledVaos) if (vao) glDeleteVertexArrays(1, &vao);
         for (auto vbo : instanceVBOs) if (vbo) glDeleteBuffers(1, &vbo);
+        if (indirectBuffer) glDeleteBuffers(1, &indirectBuffer);
     }
 
-    void Update(const std::vector<std::vector<mat4>>& dataPerVariant, bool dynamic = false) {
+    // CPU path: one instance VBO per variant
+    void Update(const std::vector<std::vector<PackedInstance>>& dataPerVariant, bool dynamic = false) {
         const size_t N = min(dataPerVariant.size(), instanceVBOs.size());
 
         for (size_t i = 0; i < N; i++) {
-            std::vector<mat4> data = dataPerVariant[i];
+            if (!instanceVBOs[i]) {
+                glGenBuffers(1, &instanceVBOs[i]);
+                glBindVertexArray(vaos[i]);
+                bindInstanceAttribs(instanceVBOs[i]);
+                glBindVertexArray(0);
+            }
+
+            const std::vector<PackedInstance>& data = dataPerVariant[i];
             instanceCounts[i] = (GLsizei)data.size();
             glBindBuffer(GL_ARRAY_BUFFER, instanceVBOs[i]);
-            glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(mat4), data.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(PackedInstance), data.data(), dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        }
+    }
+
+    // GPU path: variant i reads capacityPerVariant slots of instanceBuffer starting at i * capacityPerVariant
+    void SetIndirectSource(GLuint instanceBuffer, GLuint countBuffer, GLuint capacityPerVariant) {
+        const size_t N = geoms.size();
+
+        std::vector<std::vector<DrawRange>> ranges(N);
+        firstCommand.resize(N);
+        size_t commands = 0;
+        for (size_t i = 0; i < N; i++) {
+            ranges[i] = geoms[i]->getLods();
+            firstCommand[i] = commands;
+            commands += ranges[i].size();
+
+            glBindVertexArray(vaos[i]);
+            bindInstanceAttribs(instanceBuffer);
+        }
+        glBindVertexArray(0);
+
+        indirectBuffer = createIndirectCommands(ranges, indexed, countBuffer, capacityPerVariant, indirectBuffer);
+    }
+
+    // Culled path: commands at offset in commandBuffer use the same layout as SetIndirectSource built,
+    // with instances read from visibleBuffer. Shadow passes keep the unculled source.
+    void SetCulledSource(GLuint visibleBuffer, GLuint commandBuffer, GLintptr offset) {
+        const size_t N = geoms.size();
+        culledVaos.resize(N, 0);
+        for (size_t i = 0; i < N; i++) {
+            if (!culledVaos[i]) glGenVertexArrays(1, &culledVaos[i]);
+            glBindVertexArray(culledVaos[i]);
+
+            glBindBuffer(GL_ARRAY_BUFFER, geoms[i]->getVBO());
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+            if (indexed) glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geoms[i]->getEBO());
+            bindInstanceAttribs(visibleBuffer);
         }
+        glBindVertexArray(0);
+
+        culledCommands = commandBuffer;
+        culledOffset = offset;
     }
 
-    void Draw(RenderState& state) {
+    // viewDist: camera distance used for screen-size LOD selection (0 = full detail)
+    void Draw(RenderState& state, float viewDist = 0.0f) {
         shader->Bind(state);
 
         const size_t N = geoms.size();
+        if (indirectBuffer) {
+            bool culled = culledCommands && !state.shadowPass;
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled ? culledCommands : indirectBuffer);
+            for (size_t i = 0; i < N; i++) {
+                int lod = geoms[i]->selectLod(viewDist, state.P);
+                glBindVertexArray(culled ? culledVaos[i] : vaos[i]);
+                const void* cmd = (void*)((culled ? culledOffset : 0) + (firstCommand[i] + lod) * indirectStride(indexed));
+                if (indexed) glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, cmd);
+                else glDrawArraysIndirect(GL_TRIANGLES, cmd);
+            }
+            return;
+        }
+
         for (size_t i = 0; i < N; i++) {
+            if (instanceCounts[i] == 0) continue;
+            const DrawRange& r = geoms[i]->getLods()[geoms[i]->selectLod(viewDist, state.P)];
             glBindVertexArray(vaos[i]);
-            glDrawArraysInstanced(GL_TRIANGLES, 0, geoms[i]->getVertexCount(), instanceCounts[i]);
+            if (indexed) glDrawElementsInstancedBaseVertex(GL_TRIANGLES, r.count, GL_UNSIGNED_INT, (void*)(r.first * sizeof(uint32_t)), instanceCounts[i], r.baseVertex);
+            else glDrawArraysInstanced(GL_TRIANGLES, r.first, r.count, instanceCounts[i]);
         }
     }
 
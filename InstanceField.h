@@ -3,62 +3,77 @@
 #include "geometry.h"
 #include "shader.h"
 #include "InstanceBatch.h"
-#include "TerrainHeightCS.h"
+#include "TreeScatterCS.h"
+#include "ImpostorBatch.h"
+#include "OcclusionCuller.h"
 
+// Per-chunk instance placement, scattered once on the GPU and shared by every batch drawn on top of it
+// (e.g. trunks and crowns of the same trees).
 class InstanceField {
-    std::unique_ptr<InstanceBatch> batch;
-    TerrainHeightCS* terrainHeightCS;
-    GLuint segSSBO = 0, segCount = 0;
-    int scatterSeed = 0;
+    std::vector<std::unique_ptr<InstanceBatch>> batches;
+    std::unique_ptr<ImpostorBatch> impostors; // stand-in for all batches at a distance
+    GLuint countSSBO = 0;       // one uint per variant
+    GLuint instanceSSBO = 0;    // capacityPerVariant PackedInstance slots per variant
+    int capacityPerVariant = 0;
 
 public:
-    InstanceField(const vec3& chunkId, float chunkSize, std::vector<Geometry*> geoms, Shader* instanceShader, TerrainHeightCS* terrainHeightCS, GLuint segSSBO, GLuint segCount) : terrainHeightCS(terrainHeightCS), segSSBO(segSSBO), segCount(segCount) {
-        batch = std::make_unique<InstanceBatch>(geoms, instanceShader);
+    static constexpr int MAX_PER_CHUNK = 4;
 
-        std::vector<std::vector<mat4>> perVariantInstanceMatrices;
-        perVariantInstanceMatrices.resize(geoms.size());
-        scatterCPU(chunkId, chunkSize, perVariantInstanceMatrices);
-        batch->Update(perVariantInstanceMatrices, false);
-    }
+    InstanceField(const vec3& chunkId, float chunkSize, int variantCount, TreeScatterCS* scatterCS, GLuint segSSBO, GLuint segCount, float ratePerChunk = 2.0f, int maxPerChunk = MAX_PER_CHUNK) {
+        // Every instance may land in the same variant
+        capacityPerVariant = maxPerChunk;
 
-    void Draw(RenderState& state) {
-        batch->Draw(state);
-    }
+        std::vector<GLuint> zeros(variantCount, 0u);
+        glGenBuffers(1, &countSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, countSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, variantCount * sizeof(GLuint), zeros.data(), GL_STATIC_DRAW);
 
-private:
-    void scatterCPU(const vec3& chunkId, float chunkSize, std::vector<std::vector<mat4>>& outPerVariant, float ratePerChunk = 2.0f, int maxPerChunk = 4) {
-        // Deterministic per-chunk RNG
-        uint32_t seed = hash3(chunkId);
-        std::mt19937 rng(seed);
+        glGenBuffers(1, &instanceSSBO);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceSSBO);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(variantCount) * capacityPerVariant * sizeof(PackedInstance), nullptr, GL_STATIC_DRAW);
 
-        // How many to spawn this chunk
-        std::poisson_distribution<int> pois(ratePerChunk);
-        int count = min(pois(rng), maxPerChunk); // cap extreme outliers
+        // Deterministic per-chunk seed
+        uint32_t seed = hash3(chunkId);
+        const float maxHeight = 50.0f;
+        scatterCS->Dispatch(chunkId, chunkSize, seed, ratePerChunk, maxPerChunk, variantCount, capacityPerVariant, maxHeight, countSSBO, instanceSSBO, segSSBO, segCount);
+    }
 
-        auto randf = [&](float a, float b) {
-            std::uniform_real_distribution<float> d(a, b);
-            return d(rng);
-        };
+    ~InstanceField() {
+        batches.clear();
+        impostors.reset();
+        if (instanceSSBO) glDeleteBuffers(1, &instanceSSBO);
+        if (countSSBO) glDeleteBuffers(1, &countSSBO);
+    }
 
-        std::uniform_int_distribution<int> variantPicker(0, max(0, int(outPerVariant.size()) - 1));
+    void AddBatch(std::vector<Geometry*> geoms, Shader* instanceShader) {
+        auto batch = std::make_unique<InstanceBatch>(geoms, instanceShader);
+        batch->SetIndirectSource(instanceSSBO, countSSBO, capacityPerVariant);
+        batches.push_back(std::move(batch));
+    }
 
-        for (int i = 0; i < count; ++i) {
-            float x = (std::floor(chunkId.x) + randf(0.f, 1.f)) * chunkSize;
-            float z = (std::floor(chunkId.z) + randf(0.f, 1.f)) * chunkSize;
+    void SetImpostors(ImpostorAtlas* atlas, Shader* impostorShader) {
+        impostors = std::make_unique<ImpostorBatch>(atlas, impostorShader, instanceSSBO, countSSBO, capacityPerVariant);
+    }
 
-            // Sample height
-            float objHeight = 0.0f;
-            float maxHeight = 50.0f;
-            terrainHeightCS->Dispatch(vec3(x, maxHeight, z), maxHeight, objHeight, segSSBO, segCount);
-            if (objHeight < 0.01f) continue; // skip if underground
+    // Hand the scattered instances to the chunk cull; call after the batches and impostors are set up.
+    // Batches are expected in TreeBatch order (trunks, crowns).
+    void SetCulling(OcclusionCuller* culler, int slot) {
+        culler->RegisterTrees(slot, instanceSSBO, countSSBO);
+        for (size_t b = 0; b < batches.size() && b < TREE_IMPOSTORS; b++)
+            batches[b]->SetCulledSource(culler->getVisibleTrees(), culler->getCommandBuffer(), culler->TreeCommandOffset(slot, (TreeBatch)b));
+        if (impostors) impostors->SetCulledSource(culler->getVisibleTrees(), culler->getCommandBuffer(), culler->TreeCommandOffset(slot, TREE_IMPOSTORS));
+    }
 
-            vec3 pos = vec3(x, objHeight, z);
-            float yaw = randf(0.0f, 2.0f * M_PI);
-            mat4 M = TranslateMatrix(pos) * RotationMatrix(yaw, vec3(0.0f, 1.0f, 0.0f)) * ScaleMatrix(vec3(1.0f, 1.0f, 1.0f));
+    // viewDist picks the LOD of every batch
+    void Draw(RenderState& state, float viewDist = 0.0f) {
+        for (auto& batch : batches) batch->Draw(state, viewDist);
+    }
 
-            int variant = variantPicker(rng);
-            outPerVariant[variant].push_back(M);
-        }
+    void DrawImpostors(RenderState& state, float viewDist = 0.0f) {
+        if (impostors) impostors->Draw(state);
+        else Draw(state, viewDist);
     }
-};
 
+    InstanceField(const InstanceField&) = delete;
+    InstanceField& operator=(const InstanceField&) = delete;
+};
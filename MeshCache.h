@@ -0,0 +1,80 @@
+#pragma once
+#include "framework.h"
+#include "geometry.h"
+#include <fstream>
+
+// On-disk cache for CPU-generated meshes (e.g. all LODs of one prop).
+// Entries are keyed by a hash of everything the mesh depends on; bump VERSION when a generator changes.
+struct MeshCache {
+	static constexpr uint32_t MAGIC = 0x3148534D; // "MSH1"
+	static constexpr uint32_t VERSION = 3;
+
+	std::string dir = "meshcache";
+
+	MeshCache() {
+		CreateDirectoryA(dir.c_str(), nullptr); // fails harmlessly if it exists
+	}
+
+	// FNV-1a over the raw bytes of the settings
+	static uint64_t key(std::initializer_list<float> settings) {
+		uint64_t h = 1469598103934665603ull;
+		auto mix = [&h](const void* data, size_t size) {
+			const unsigned char* b = (const unsigned char*)data;
+			for (size_t i = 0; i < size; i++) { h ^= b[i]; h *= 1099511628211ull; }
+		};
+		const uint32_t version = VERSION;
+		mix(&version, sizeof(version));
+		for (float f : settings) mix(&f, sizeof(f));
+		return h;
+	}
+
+	std::string path(const std::string& name, uint64_t key) const {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)key);
+		return dir + "/" + name + "_" + buf + ".bin";
+	}
+
+	bool load(const std::string& name, uint64_t key, std::vector<IndexedMesh>& meshes) const {
+		std::ifstream file(path(name, key), std::ios::binary);
+		if (!file) return false;
+
+		uint32_t magic = 0, meshCount = 0;
+		uint64_t storedKey = 0;
+		file.read((char*)&magic, sizeof(magic));
+		file.read((char*)&storedKey, sizeof(storedKey));
+		file.read((char*)&meshCount, sizeof(meshCount));
+		if (!file || magic != MAGIC || storedKey != key) return false;
+
+		meshes.resize(meshCount);
+		for (IndexedMesh& m : meshes) {
+			uint32_t vtxCount = 0, idxCount = 0;
+			file.read((char*)&vtxCount, sizeof(vtxCount));
+			file.read((char*)&idxCount, sizeof(idxCount));
+			if (!file) return false;
+
+			m.vtx.resize(vtxCount);
+			m.idx.resize(idxCount);
+			file.read((char*)m.vtx.data(), std::streamsize(vtxCount) * sizeof(vec3));
+			file.read((char*)m.idx.data(), std::streamsize(idxCount) * sizeof(uint32_t));
+		}
+		return (bool)file;
+	}
+
+	void store(const std::string& name, uint64_t key, const std::vector<IndexedMesh>& meshes) const {
+		std::ofstream file(path(name, key), std::ios::binary | std::ios::trunc);
+		if (!file) return;
+
+		uint32_t magic = MAGIC, meshCount = (uint32_t)meshes.size();
+		file.write((const char*)&magic, sizeof(magic));
+		file.write((const char*)&key, sizeof(key));
+		file.write((const char*)&meshCount, sizeof(meshCount));
+
+		for (const IndexedMesh& m : meshes) {
+			uint32_t vtxCount = (uint32_t)m.vtx.size(), idxCount = (uint32_t)m.idx.size();
+			file.write((const char*)&vtxCount, sizeof(vtxCount));
+			file.write((const char*)&idxCount, sizeof(idxCount));
+			file.write((const char*)m.vtx.data(), std::streamsize(vtxCount) * sizeof(vec3));
+			file.write((const char*)m.idx.data(), std::streamsize(idxCount) * sizeof(uint32_t));
+		}
+	}
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include "framework.h"
 #include <functional>
+#include <thread>
+#include "lut.h"
 
 struct MeshGenerator {
     virtual ~MeshGenerator() = default;
@@ -8,127 +10,226 @@ struct MeshGenerator {
 };
 
 
+// (u, v) grid over [0, 1]^2 with tesselation quads per side.
+// The indexed output shares every grid vertex. Quads are emitted in column bands of BAND_CELLS, so the row
+// above is still in the post-transform vertex cache. Vertices are stored in first-use order.
 struct ParametricMeshGenerator : MeshGenerator {
+    static constexpr int BAND_CELLS = 16;
+
     int tesselation;
     std::function<vec3(float u, float v)> eval;
 
     ParametricMeshGenerator(int tesselation, std::function<vec3(float, float)> eval) : tesselation(tesselation), eval(eval) {}
 
+    // Un-indexed output
     void generate(std::vector<vec3>& vtxData) override {
-        vtxData.reserve(tesselation * tesselation * 6); // 6 verts per quad
-
-        const float step = 1.0f / float(tesselation);
+        std::vector<vec3> verts;
+        std::vector<uint32_t> indices;
+        generate(verts, indices);
 
-        for (int i = 0; i < tesselation; ++i) {
-            float v0 = float(i) * step;
-            float v1 = float(i + 1) * step;
-
-            for (int j = 0; j < tesselation; ++j) {
-                float u0 = float(j) * step;
-                float u1 = float(j + 1) * step;
+        vtxData.clear();
+        vtxData.reserve(indices.size());
+        for (uint32_t i : indices) vtxData.push_back(verts[i]);
+    }
 
-                // Sample the four corners
-                vec3 p00 = eval(u0, v0);
-                vec3 p10 = eval(u1, v0);
-                vec3 p11 = eval(u1, v1);
-                vec3 p01 = eval(u0, v1);
+    void generate(std::vector<vec3>& vtxData, std::vector<uint32_t>& idxData) {
+        const int side = tesselation + 1;
+        const float step = 1.0f / float(tesselation);
 
-                // Emit two triangles
-                vtxData.push_back(p11);
-                vtxData.push_back(p10);
-                vtxData.push_back(p00);
+        // Grid indices (row i along v, column j along u), band by band
+        idxData.clear();
+        idxData.reserve(size_t(tesselation) * tesselation * 6);
+        for (int band = 0; band < tesselation; band += BAND_CELLS) {
+            const int bandEnd = min(band + BAND_CELLS, tesselation);
+            for (int i = 0; i < tesselation; ++i) {
+                for (int j = band; j < bandEnd; ++j) {
+                    uint32_t p00 = i * side + j;
+                    uint32_t p10 = p00 + 1;
+                    uint32_t p01 = p00 + side;
+                    uint32_t p11 = p01 + 1;
+
+                    // Two triangles
+                    idxData.push_back(p11);
+                    idxData.push_back(p10);
+                    idxData.push_back(p00);
+
+                    idxData.push_back(p01);
+                    idxData.push_back(p11);
+                    idxData.push_back(p00);
+                }
+            }
+        }
 
-                vtxData.push_back(p01);
-                vtxData.push_back(p11);
-                vtxData.push_back(p00);
+        // Evaluate each grid vertex once, numbered by first use
+        std::vector<int> remap(size_t(side) * side, -1);
+        vtxData.clear();
+        vtxData.reserve(remap.size());
+        for (uint32_t& g : idxData) {
+            if (remap[g] < 0) {
+                remap[g] = (int)vtxData.size();
+                vtxData.push_back(eval(float(g % side) * step, float(g / side) * step));
             }
+            g = (uint32_t)remap[g];
         }
     }
 };
 
 
+// Marching cubes over [-scale, scale]^3, templated on the SDF so calls can inline.
+// Corner values are kept for two z-slabs so each corner is evaluated once, and edge vertices
+// are shared through per-plane index caches. With threads > 1 the z range is split into bands
+// that run independently (vertices on band borders are duplicated) and are concatenated after.
+template <typename Sdf>
 struct SdfMeshGenerator : MeshGenerator {
     float scale;
     int tesselation;
-    std::function<float(vec3)> sdf;
+    Sdf sdf;
+    int threads;
 
-    SdfMeshGenerator(int tesselation, float scale, std::function<float(vec3)> sdf) : scale(scale), tesselation(tesselation), sdf(sdf) {}
+    SdfMeshGenerator(int tesselation, float scale, Sdf sdf, int threads = 1) : scale(scale), tesselation(tesselation), sdf(sdf), threads(threads) {}
 
+    // Un-indexed output
     void generate(std::vector<vec3>& vtxData) override {
-        vtxData.reserve(tesselation * tesselation * tesselation * 15);
-
-        const float step = (scale * 2.0f) / float(tesselation);
-
-        for (int i = 0; i < tesselation; i++) {
-            float x0 = -scale + i * step;
-            for (int j = 0; j < tesselation; j++) {
-                float y0 = -scale + j * step;
-                for (int k = 0; k < tesselation; k++) {
-                    float z0 = -scale + k * step;
-                    vec3 p[8];
-                    float val[8];
-
-                    // Define cube vertices
-                    p[0] = vec3(x0,         y0,         z0);
-                    p[1] = vec3(x0 + step,  y0,         z0);
-                    p[2] = vec3(x0 + step,  y0 + step,  z0);
-                    p[3] = vec3(x0,         y0 + step,  z0);
-                    p[4] = vec3(x0,         y0,         z0 + step);
-                    p[5] = vec3(x0 + step,  y0,         z0 + step);
-                    p[6] = vec3(x0 + step,  y0 + step,  z0 + step);
-                    p[7] = vec3(x0,         y0 + step,  z0 + step);
-
-                    // Evaluate scalar field at cube vertices
-                    for (int n = 0; n < 8; n++)
-                        val[n] = sdf(p[n]);
-
-                    // Determine cube index
+        std::vector<vec3> verts;
+        std::vector<uint32_t> indices;
+        generate(verts, indices);
+
+        vtxData.clear();
+        vtxData.reserve(indices.size());
+        for (uint32_t i : indices) vtxData.push_back(verts[i]);
+    }
+
+    void generate(std::vector<vec3>& vtxData, std::vector<uint32_t>& idxData) {
+        vtxData.clear();
+        idxData.clear();
+
+        const int bands = max(1, min(threads, tesselation));
+        if (bands == 1) {
+            generateBand(0, tesselation, vtxData, idxData);
+            return;
+        }
+
+        std::vector<std::vector<vec3>> bandVtx(bands);
+        std::vector<std::vector<uint32_t>> bandIdx(bands);
+        std::vector<std::thread> workers;
+        for (int b = 0; b < bands; b++) {
+            int k0 = tesselation * b / bands;
+            int k1 = tesselation * (b + 1) / bands;
+            workers.emplace_back([this, &bandVtx, &bandIdx, b, k0, k1]() { generateBand(k0, k1, bandVtx[b], bandIdx[b]); });
+        }
+        for (auto& w : workers) w.join();
+
+        for (int b = 0; b < bands; b++) {
+            uint32_t base = (uint32_t)vtxData.size();
+            vtxData.insert(vtxData.end(), bandVtx[b].begin(), bandVtx[b].end());
+            for (uint32_t i : bandIdx[b]) idxData.push_back(base + i);
+        }
+    }
+
+    static vec3 VertexInterp(float isolevel, vec3 p1, vec3 p2, float valp1, float valp2) {
+        if (fabs(valp1 - valp2) < 0.00001) return p1;
+        float mu = (isolevel - valp1) / (valp2 - valp1);
+        return p1 + mu * (p2 - p1);
+    }
+
+private:
+    // Cells with z index in [k0, k1)
+    void generateBand(int k0, int k1, std::vector<vec3>& vtxData, std::vector<uint32_t>& idxData) const {
+        const int n = tesselation;
+        const int c = n + 1; // corners per axis
+        const float step = (scale * 2.0f) / float(n);
+
+        auto cornerPos = [&](int i, int j, int k) { return vec3(-scale + i * step, -scale + j * step, -scale + k * step); };
+
+        // Corner values of the slab's bottom (0) and top (1) plane, [j * c + i]
+        std::vector<float> val0(c * c), val1(c * c);
+        // Vertex index per edge, -1 until created. x-edges [j * n + i], y-edges and z-edges [j * c + i]
+        std::vector<int> xEdge0(c * n, -1), yEdge0(n * c, -1), xEdge1(c * n), yEdge1(n * c), zEdge(c * c);
+
+        auto evalPlane = [&](int k, std::vector<float>& vals) {
+            for (int j = 0; j < c; j++)
+                for (int i = 0; i < c; i++)
+                    vals[j * c + i] = sdf(cornerPos(i, j, k));
+        };
+
+        // Edges are always interpolated low -> high so neighbouring cells agree
+        auto edgeVertex = [&](int& slot, const vec3& a, const vec3& b, float va, float vb) {
+            if (slot < 0) {
+                slot = (int)vtxData.size();
+                vtxData.push_back(VertexInterp(0.0f, a, b, va, vb));
+            }
+            return slot;
+        };
+
+        evalPlane(k0, val0);
+        for (int k = k0; k < k1; k++) {
+            evalPlane(k + 1, val1);
+            std::fill(xEdge1.begin(), xEdge1.end(), -1);
+            std::fill(yEdge1.begin(), yEdge1.end(), -1);
+            std::fill(zEdge.begin(), zEdge.end(), -1);
+
+            for (int j = 0; j < n; j++) {
+                for (int i = 0; i < n; i++) {
+                    const int c00 = j * c + i, c10 = c00 + 1, c11 = c00 + c + 1, c01 = c00 + c;
+
+                    // Same corner order as the lookup tables
+                    float val[8] = { val0[c00], val0[c10], val0[c11], val0[c01], val1[c00], val1[c10], val1[c11], val1[c01] };
+
                     int cubeindex = 0;
-                    for (int n = 0; n < 8; n++)
-                        if (val[n] < 0.0f) cubeindex |= 1 << n;
+                    for (int m = 0; m < 8; m++)
+                        if (val[m] < 0.0f) cubeindex |= 1 << m;
 
                     // Skip if the cube is entirely inside or outside
-                    if (edgeTable[cubeindex] == 0)
-                        continue;
-
-                    // Find the vertices where the surface intersects the cube
-                    vec3 vertlist[12];
-                    if (edgeTable[cubeindex] & 1)       vertlist[0] = VertexInterp(0.0f, p[0], p[1], val[0], val[1]);
-                    if (edgeTable[cubeindex] & 2)       vertlist[1] = VertexInterp(0.0f, p[1], p[2], val[1], val[2]);
-                    if (edgeTable[cubeindex] & 4)       vertlist[2] = VertexInterp(0.0f, p[2], p[3], val[2], val[3]);
-                    if (edgeTable[cubeindex] & 8)       vertlist[3] = VertexInterp(0.0f, p[3], p[0], val[3], val[0]);
-                    if (edgeTable[cubeindex] & 16)      vertlist[4] = VertexInterp(0.0f, p[4], p[5], val[4], val[5]);
-                    if (edgeTable[cubeindex] & 32)      vertlist[5] = VertexInterp(0.0f, p[5], p[6], val[5], val[6]);
-                    if (edgeTable[cubeindex] & 64)      vertlist[6] = VertexInterp(0.0f, p[6], p[7], val[6], val[7]);
-                    if (edgeTable[cubeindex] & 128)     vertlist[7] = VertexInterp(0.0f, p[7], p[4], val[7], val[4]);
-                    if (edgeTable[cubeindex] & 256)     vertlist[8] = VertexInterp(0.0f, p[0], p[4], val[0], val[4]);
-                    if (edgeTable[cubeindex] & 512)     vertlist[9] = VertexInterp(0.0f, p[1], p[5], val[1], val[5]);
-                    if (edgeTable[cubeindex] & 1024)    vertlist[10] = VertexInterp(0.0f, p[2], p[6], val[2], val[6]);
-                    if (edgeTable[cubeindex] & 2048)    vertlist[11] = VertexInterp(0.0f, p[3], p[7], val[3], val[7]);
+                    const int edges = edgeTable[cubeindex];
+                    if (edges == 0) continue;
+
+                    vec3 p[8] = {
+                        cornerPos(i, j, k),     cornerPos(i + 1, j, k),     cornerPos(i + 1, j + 1, k),     cornerPos(i, j + 1, k),
+                        cornerPos(i, j, k + 1), cornerPos(i + 1, j, k + 1), cornerPos(i + 1, j + 1, k + 1), cornerPos(i, j + 1, k + 1)
+                    };
+
+                    int vertlist[12];
+                    if (edges & 1)      vertlist[0]  = edgeVertex(xEdge0[j * n + i],       p[0], p[1], val[0], val[1]);
+                    if (edges & 2)      vertlist[1]  = edgeVertex(yEdge0[j * c + i + 1],   p[1], p[2], val[1], val[2]);
+                    if (edges & 4)      vertlist[2]  = edgeVertex(xEdge0[(j + 1) * n + i], p[3], p[2], val[3], val[2]);
+                    if (edges & 8)      vertlist[3]  = edgeVertex(yEdge0[j * c + i],       p[0], p[3], val[0], val[3]);
+                    if (edges & 16)     vertlist[4]  = edgeVertex(xEdge1[j * n + i],       p[4], p[5], val[4], val[5]);
+                    if (edges & 32)     vertlist[5]  = edgeVertex(yEdge1[j * c + i + 1],   p[5], p[6], val[5], val[6]);
+                    if (edges & 64)     vertlist[6]  = edgeVertex(xEdge1[(j + 1) * n + i], p[7], p[6], val[7], val[6]);
+                    if (edges & 128)    vertlist[7]  = edgeVertex(yEdge1[j * c + i],       p[4], p[7], val[4], val[7]);
+                    if (edges & 256)    vertlist[8]  = edgeVertex(zEdge[c00],              p[0], p[4], val[0], val[4]);
+                    if (edges & 512)    vertlist[9]  = edgeVertex(zEdge[c10],              p[1], p[5], val[1], val[5]);
+                    if (edges & 1024)   vertlist[10] = edgeVertex(zEdge[c11],              p[2], p[6], val[2], val[6]);
+                    if (edges & 2048)   vertlist[11] = edgeVertex(zEdge[c01],              p[3], p[7], val[3], val[7]);
 
                     // Create triangles
-                    for (int n = 0; triTable[cubeindex][n] != -1; n += 3) {
-                        vec3 v0 = vertlist[triTable[cubeindex][n]];
-                        vec3 v1 = vertlist[triTable[cubeindex][n + 1]];
-                        vec3 v2 = vertlist[triTable[cubeindex][n + 2]];
-
-                        // Add vertices
-                        vtxData.push_back(v0);
-                        vtxData.push_back(v2);
-                        vtxData.push_back(v1);
+                    for (int m = 0; triTable[cubeindex][m] != -1; m += 3) {
+                        int v0 = vertlist[triTable[cubeindex][m]];
+                        int v1 = vertlist[triTable[cubeindex][m + 1]];
+                        int v2 = vertlist[triTable[cubeindex][m + 2]];
+                        if (v0 == v1 || v1 == v2 || v0 == v2) continue;
+
+                        idxData.push_back(v0);
+                        idxData.push_back(v2);
+                        idxData.push_back(v1);
                     }
                 }
             }
-        }
-    }
 
-    vec3 VertexInterp(float isolevel, vec3 p1, vec3 p2, float valp1, float valp2) {
-        if (fabs(valp1 - valp2) < 0.00001) return p1;
-        float mu = (isolevel - valp1) / (valp2 - valp1);
-        return p1 + mu * (p2 - p1);
+            // Top plane becomes the next slab's bottom
+            std::swap(val0, val1);
+            std::swap(xEdge0, xEdge1);
+            std::swap(yEdge0, yEdge1);
+        }
     }
 };
 
+// Deduces the SDF type, e.g. auto gen = makeSdfMeshGenerator(32, 128.0f, [](vec3 p) { ... });
+template <typename Sdf>
+SdfMeshGenerator<Sdf> makeSdfMeshGenerator(int tesselation, float scale, Sdf sdf, int threads = 1) {
+    return SdfMeshGenerator<Sdf>(tesselation, scale, sdf, threads);
+}
+
 
 struct LeafCloudGenerator : MeshGenerator {
     // Controls
@@ -0,0 +1,276 @@
+#pragma once
+#include "framework.h"
+#include "geometry.h"
+#include <queue>
+
+// Quadric error metric edge collapse (Garland & Heckbert) on indexed triangle meshes.
+// Cheapest edge first, with stale heap entries skipped through per-vertex stamps.
+// Collapses that would flip a triangle or make the mesh non-manifold are rejected.
+class MeshSimplifier {
+	// Symmetric 4x4 stored as its upper triangle
+	struct Quadric {
+		double a[10] = {};
+
+		Quadric() {}
+		Quadric(double x, double y, double z, double w) {
+			a[0] = x * x; a[1] = x * y; a[2] = x * z; a[3] = x * w;
+			a[4] = y * y; a[5] = y * z; a[6] = y * w;
+			a[7] = z * z; a[8] = z * w;
+			a[9] = w * w;
+		}
+
+		Quadric operator+(const Quadric& q) const { Quadric r; for (int i = 0; i < 10; i++) r.a[i] = a[i] + q.a[i]; return r; }
+		Quadric operator*(double s) const { Quadric r; for (int i = 0; i < 10; i++) r.a[i] = a[i] * s; return r; }
+		void operator+=(const Quadric& q) { for (int i = 0; i < 10; i++) a[i] += q.a[i]; }
+
+		double error(const vec3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+				 + a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+				 + a[7] * z * z + 2.0 * a[8] * z
+				 + a[9];
+		}
+
+		// Point of minimal error, false when the 3x3 system is (near) singular
+		bool optimum(vec3& out) const {
+			double det = a[0] * (a[4] * a[7] - a[5] * a[5]) - a[1] * (a[1] * a[7] - a[5] * a[2]) + a[2] * (a[1] * a[5] - a[4] * a[2]);
+			if (fabs(det) < 1e-10) return false;
+
+			// Cramer's rule for A p = -b
+			double bx = -a[3], by = -a[6], bz = -a[8];
+			double dx = bx * (a[4] * a[7] - a[5] * a[5]) - a[1] * (by * a[7] - a[5] * bz) + a[2] * (by * a[5] - a[4] * bz);
+			double dy = a[0] * (by * a[7] - bz * a[5]) - bx * (a[1] * a[7] - a[5] * a[2]) + a[2] * (a[1] * bz - by * a[2]);
+			double dz = a[0] * (a[4] * bz - a[5] * by) - a[1] * (a[1] * bz - by * a[2]) + bx * (a[1] * a[5] - a[4] * a[2]);
+			out = vec3(float(dx / det), float(dy / det), float(dz / det));
+			return true;
+		}
+	};
+
+	struct Candidate {
+		double cost;
+		uint32_t v0, v1;
+		uint32_t stamp0, stamp1;
+		vec3 target;
+		bool operator>(const Candidate& o) const { return cost > o.cost; }
+	};
+
+	std::vector<vec3> pos;
+	std::vector<Quadric> quadrics;
+	std::vector<uint32_t> stamps;
+	std::vector<bool> deadVertex;
+	std::vector<std::vector<uint32_t>> vertexTris;
+
+	std::vector<uint32_t> tris; // 3 per triangle
+	std::vector<bool> deadTri;
+	size_t liveTris = 0;
+
+	std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+	static constexpr double BOUNDARY_WEIGHT = 1000.0; // keeps open borders in place
+	static constexpr float MIN_NORMAL_DOT = 0.2f;     // reject collapses that fold triangles
+
+	vec3 triNormal(uint32_t t, uint32_t moved, const vec3& movedPos, uint32_t other) const {
+		vec3 p[3];
+		for (int k = 0; k < 3; k++) {
+			uint32_t v = tris[3 * t + k];
+			p[k] = (v == moved || v == other) ? movedPos : pos[v];
+		}
+		return cross(p[1] - p[0], p[2] - p[0]);
+	}
+
+	bool hasVertex(uint32_t t, uint32_t v) const {
+		return tris[3 * t] == v || tris[3 * t + 1] == v || tris[3 * t + 2] == v;
+	}
+
+	void pushCandidate(uint32_t a, uint32_t b) {
+		Quadric q = quadrics[a] + quadrics[b];
+		vec3 mid = (pos[a] + pos[b]) * 0.5f;
+
+		// Optimal point unless it lands far away from the edge (ill-conditioned), else best of endpoints and midpoint
+		vec3 target;
+		double cost;
+		float edgeLen = length(pos[b] - pos[a]);
+		if (q.optimum(target) && length(target - mid) <= edgeLen) {
+			cost = q.error(target);
+		}
+		else {
+			target = pos[a];
+			cost = q.error(pos[a]);
+			double eb = q.error(pos[b]), em = q.error(mid);
+			if (eb < cost) { cost = eb; target = pos[b]; }
+			if (em < cost) { cost = em; target = mid; }
+		}
+
+		heap.push({ max(cost, 0.0), a, b, stamps[a], stamps[b], target });
+	}
+
+	// Link condition plus normal flip test
+	bool canCollapse(uint32_t v0, uint32_t v1, const vec3& target) const {
+		std::vector<uint32_t> ring0, ring1;
+		int shared = 0;
+
+		for (uint32_t t : vertexTris[v0]) {
+			if (deadTri[t]) continue;
+			if (hasVertex(t, v1)) { shared++; continue; }
+			for (int k = 0; k < 3; k++) if (tris[3 * t + k] != v0) ring0.push_back(tris[3 * t + k]);
+		}
+		for (uint32_t t : vertexTris[v1]) {
+			if (deadTri[t] || hasVertex(t, v0)) continue;
+			for (int k = 0; k < 3; k++) if (tris[3 * t + k] != v1) ring1.push_back(tris[3 * t + k]);
+		}
+		if (shared == 0) return false;
+
+		// Only the opposite corners of the shared triangles may be neighbours of both ends
+		std::sort(ring0.begin(), ring0.end()); ring0.erase(std::unique(ring0.begin(), ring0.end()), ring0.end());
+		std::sort(ring1.begin(), ring1.end()); ring1.erase(std::unique(ring1.begin(), ring1.end()), ring1.end());
+		int common = 0;
+		for (uint32_t v : ring0) if (std::binary_search(ring1.begin(), ring1.end(), v)) common++;
+		if (common > shared) return false;
+
+		for (uint32_t v : { v0, v1 }) {
+			for (uint32_t t : vertexTris[v]) {
+				if (deadTri[t] || (hasVertex(t, v0) && hasVertex(t, v1))) continue;
+				vec3 before = triNormal(t, v, pos[v], v);
+				vec3 after = triNormal(t, v0, target, v1);
+				float lb = length(before), la = length(after);
+				if (la < 1e-8f) return false;
+				if (lb > 1e-8f && dot(before, after) < MIN_NORMAL_DOT * lb * la) return false;
+			}
+		}
+		return true;
+	}
+
+	void collapse(uint32_t v0, uint32_t v1, const vec3& target) {
+		for (uint32_t t : vertexTris[v1]) {
+			if (deadTri[t]) continue;
+			if (hasVertex(t, v0)) {
+				deadTri[t] = true;
+				liveTris--;
+				continue;
+			}
+			for (int k = 0; k < 3; k++) if (tris[3 * t + k] == v1) tris[3 * t + k] = v0;
+			vertexTris[v0].push_back(t);
+		}
+		vertexTris[v1].clear();
+		deadVertex[v1] = true;
+
+		// Drop references to removed triangles
+		auto& list = vertexTris[v0];
+		list.erase(std::remove_if(list.begin(), list.end(), [this](uint32_t t) { return deadTri[t]; }), list.end());
+
+		pos[v0] = target;
+		quadrics[v0] += quadrics[v1];
+		stamps[v0]++;
+		stamps[v1]++;
+
+		std::vector<uint32_t> ring;
+		for (uint32_t t : list)
+			for (int k = 0; k < 3; k++) if (tris[3 * t + k] != v0) ring.push_back(tris[3 * t + k]);
+		std::sort(ring.begin(), ring.end());
+		ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+		for (uint32_t n : ring) pushCandidate(v0, n);
+	}
+
+public:
+	// Collapses edges until at most targetTris triangles remain (or no valid collapse is left)
+	IndexedMesh simplify(const IndexedMesh& mesh, size_t targetTris) {
+		const size_t V = mesh.vtx.size();
+		const size_t T = mesh.idx.size() / 3;
+
+		pos = mesh.vtx;
+		tris = mesh.idx;
+		quadrics.assign(V, Quadric());
+		stamps.assign(V, 0);
+		deadVertex.assign(V, false);
+		vertexTris.assign(V, {});
+		deadTri.assign(T, false);
+		liveTris = T;
+		heap = {};
+
+		// Face planes, and edge use counts to find open borders
+		std::vector<std::pair<uint64_t, uint32_t>> edges; // (v_lo << 32 | v_hi, triangle)
+		edges.reserve(T * 3);
+		for (uint32_t t = 0; t < T; t++) {
+			uint32_t a = tris[3 * t], b = tris[3 * t + 1], c = tris[3 * t + 2];
+			vec3 n = cross(pos[b] - pos[a], pos[c] - pos[a]);
+			float len = length(n);
+			if (len > 1e-12f) {
+				n = n / len;
+				Quadric q(n.x, n.y, n.z, -dot(n, pos[a]));
+				quadrics[a] += q; quadrics[b] += q; quadrics[c] += q;
+			}
+			for (int k = 0; k < 3; k++) {
+				uint32_t u = tris[3 * t + k], v = tris[3 * t + (k + 1) % 3];
+				edges.push_back({ (uint64_t(min(u, v)) << 32) | max(u, v), t });
+			}
+			vertexTris[a].push_back(t); vertexTris[b].push_back(t); vertexTris[c].push_back(t);
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (size_t i = 0; i < edges.size(); ) {
+			size_t j = i;
+			while (j < edges.size() && edges[j].first == edges[i].first) j++;
+			uint32_t u = uint32_t(edges[i].first >> 32), v = uint32_t(edges[i].first & 0xFFFFFFFFu);
+
+			// Border edge: constraint plane through the edge, perpendicular to its face
+			if (j - i == 1) {
+				uint32_t t = edges[i].second;
+				vec3 faceN = cross(pos[tris[3 * t + 1]] - pos[tris[3 * t]], pos[tris[3 * t + 2]] - pos[tris[3 * t]]);
+				vec3 n = cross(pos[v] - pos[u], faceN);
+				float len = length(n);
+				if (len > 1e-12f) {
+					n = n / len;
+					Quadric q = Quadric(n.x, n.y, n.z, -dot(n, pos[u])) * BOUNDARY_WEIGHT;
+					quadrics[u] += q; quadrics[v] += q;
+				}
+			}
+			pushCandidate(u, v);
+			i = j;
+		}
+
+		while (liveTris > targetTris && !heap.empty()) {
+			Candidate c = heap.top();
+			heap.pop();
+			if (deadVertex[c.v0] || deadVertex[c.v1]) continue;
+			if (c.stamp0 != stamps[c.v0] || c.stamp1 != stamps[c.v1]) continue; // stale
+			if (!canCollapse(c.v0, c.v1, c.target)) continue;
+			collapse(c.v0, c.v1, c.target);
+		}
+
+		// Compact
+		IndexedMesh out;
+		std::vector<uint32_t> remap(V, UINT32_MAX);
+		out.idx.reserve(liveTris * 3);
+		for (size_t t = 0; t < T; t++) {
+			if (deadTri[t]) continue;
+			for (int k = 0; k < 3; k++) {
+				uint32_t v = tris[3 * t + k];
+				if (remap[v] == UINT32_MAX) {
+					remap[v] = (uint32_t)out.vtx.size();
+					out.vtx.push_back(pos[v]);
+				}
+				out.idx.push_back(remap[v]);
+			}
+		}
+		return out;
+	}
+};
+
+// LOD 0 is the input, each further level keeps `ratio` of the previous level's triangles
+inline std::vector<IndexedMesh> buildLods(const IndexedMesh& base, int lodCount, float ratio = 0.5f) {
+	std::vector<IndexedMesh> lods;
+	lods.push_back(base);
+
+	MeshSimplifier simplifier;
+	for (int l = 1; l < lodCount; l++) {
+		size_t target = size_t(lods.back().triangleCount() * ratio);
+		lods.push_back(simplifier.simplify(lods.back(), target));
+	}
+	return lods;
+}
+
+inline void printLodTriangles(const char* name, const std::vector<IndexedMesh>& lods) {
+	printf("%s LOD triangles:", name);
+	for (size_t l = 0; l < lods.size(); l++) printf(" %zu", lods[l].triangleCount());
+	printf("\n");
+}
@@ -0,0 +1,263 @@
+#pragma once
+#include "framework.h"
+#include "renderstate.h"
+#include "camera.h"
+#include "geometry.h"
+#include "InstanceBatch.h"
+#include "GrassField.h"
+#include "HiZBuffer.h"
+#include "ChunkCullCS.h"
+
+// Matches ChunkCullInfo in chunk_cull.comp
+struct ChunkCullInfo {
+	vec4 boundsMin;             // tight terrain bounds
+	vec4 boundsMax;
+	vec4 origin;                // chunk corner, chunk size in .w (0 = slot unused)
+	GLuint terrainVertexCount;
+	GLuint grassTileCapacity;
+	GLuint _pad[2];
+	GLuint grassTileCount[GRASS_TILES];
+	vec2 grassTileHeight[GRASS_TILES]; // min, max blade root height
+};
+static_assert(sizeof(ChunkCullInfo) == 256, "ChunkCullInfo must match the std430 layout");
+
+// Matches the counters block in chunk_cull.comp
+struct CullCounters {
+	GLuint chunks, chunksVisible;
+	GLuint grassTiles, grassTilesVisible;
+	GLuint blades, bladesVisible;
+	GLuint trees, treesVisible;
+};
+
+// Tree batches of a chunk, in the order their commands are laid out in a slot
+enum TreeBatch { TREE_TRUNKS, TREE_CROWNS, TREE_IMPOSTORS, TREE_BATCHES };
+
+// GPU visibility for every loaded chunk in one dispatch. Each chunk owns a slot with its terrain,
+// grass tile and tree commands; the cull pass tests them against the camera frustum and last frame's
+// Hi-Z pyramid and writes their instanceCounts, so the CPU only issues indirect draws.
+// Shadow passes keep drawing from the unculled per-chunk buffers.
+class OcclusionCuller {
+	static constexpr int MAX_TREE_VARIANTS = 16; // matches chunk_cull.comp
+	static constexpr int COUNTER_LATENCY = 4;    // frames between a cull and reading its counters
+
+	ChunkCullCS* cullCS = nullptr;
+
+	int maxSlots = 0;
+	int treeVariants = 0;
+	int treeCapacity = 0;     // instances per variant and chunk
+	GLsizeiptr slotStride = 0;
+
+	GLuint infoSSBO = 0;        // ChunkCullInfo per slot
+	GLuint commandBuffer = 0;   // slotStride bytes of indirect commands per slot
+	GLuint treeSourceSSBO = 0;  // PackedInstance, copied from each chunk's scatter
+	GLuint treeVisibleSSBO = 0; // PackedInstance, survivors of the cull
+	GLuint treeCountSSBO = 0;   // per slot and variant
+	GLuint treeCommandMapSSBO = 0;
+	GLuint counterSSBO = 0;
+	GLuint counterReadback[COUNTER_LATENCY] = {};
+	int frame = 0;
+	CullCounters counters = {};
+
+	// One slot's tree commands; only baseInstance changes between slots
+	struct TreeCommand {
+		DrawRange range;
+		bool indexed;
+		GLuint variant;
+		GLintptr offset; // within the slot
+	};
+	std::vector<TreeCommand> treeCommands;
+	GLintptr treeBatchOffset[TREE_BATCHES] = {};
+
+	std::vector<vec4> treeSpheres; // object-space center.xyz, radius in .w
+	float vegetationReach = 0.0f;
+
+public:
+	HiZBuffer hiZ;
+	bool enabled = true;
+
+	OcclusionCuller(int maxSlots, const std::vector<Geometry*>& trunks, const std::vector<Geometry*>& crowns, bool impostors, int treeCapacity)
+		: maxSlots(maxSlots), treeCapacity(treeCapacity) {
+		cullCS = new ChunkCullCS();
+
+		treeVariants = min((int)trunks.size(), MAX_TREE_VARIANTS);
+
+		// Slot layout: terrain, grass tiles, then every tree batch variant-major like createIndirectCommands
+		GLintptr offset = sizeof(DrawArraysIndirectCommand) * (1 + GRASS_TILES);
+		for (int b = 0; b < TREE_BATCHES; b++) {
+			treeBatchOffset[b] = offset;
+			for (int v = 0; v < treeVariants; v++) {
+				bool indexed = b != TREE_IMPOSTORS && (b == TREE_TRUNKS ? trunks[v] : crowns[v])->isIndexed();
+				std::vector<DrawRange> ranges;
+				if (b == TREE_IMPOSTORS) { if (impostors) ranges.push_back({ 4u, 0u, 0 }); }
+				else ranges = (b == TREE_TRUNKS ? trunks[v] : crowns[v])->getLods();
+
+				for (const DrawRange& r : ranges) {
+					treeCommands.push_back({ r, indexed, (GLuint)v, offset });
+					offset += indirectStride(indexed);
+				}
+			}
+		}
+		slotStride = (offset + 15) & ~GLintptr(15);
+
+		// Bounding sphere of trunk + crown, as in the impostor atlas
+		for (int v = 0; v < treeVariants; v++) {
+			vec3 lo = minVec3(trunks[v]->getBounds().min, crowns[v]->getBounds().min);
+			vec3 hi = maxVec3(trunks[v]->getBounds().max, crowns[v]->getBounds().max);
+			vec3 center = (lo + hi) * 0.5f;
+			float R = length(hi - lo) * 0.5f;
+			treeSpheres.push_back(vec4(center.x, center.y, center.z, R));
+			vegetationReach = max(vegetationReach, length(center) + R);
+		}
+		treeSpheres.resize(MAX_TREE_VARIANTS, vec4(0.0f));
+
+		// instanceCount word of every tree command, for the cull pass to fill in
+		std::vector<GLuint> commandMap;
+		for (const TreeCommand& c : treeCommands) {
+			commandMap.push_back(GLuint((c.offset + offsetof(DrawArraysIndirectCommand, instanceCount)) / sizeof(GLuint)));
+			commandMap.push_back(c.variant);
+		}
+
+		const GLsizeiptr treeSlots = GLsizeiptr(maxSlots) * treeVariants * treeCapacity;
+		infoSSBO = createBuffer(GLsizeiptr(maxSlots) * sizeof(ChunkCullInfo), nullptr);
+		commandBuffer = createBuffer(GLsizeiptr(maxSlots) * slotStride, nullptr);
+		treeSourceSSBO = createBuffer(max(treeSlots, GLsizeiptr(1)) * sizeof(PackedInstance), nullptr);
+		treeVisibleSSBO = createBuffer(max(treeSlots, GLsizeiptr(1)) * sizeof(PackedInstance), nullptr);
+		treeCountSSBO = createBuffer(max(GLsizeiptr(maxSlots) * treeVariants, GLsizeiptr(1)) * sizeof(GLuint), nullptr);
+		treeCommandMapSSBO = createBuffer(max(commandMap.size(), size_t(2)) * sizeof(GLuint), commandMap.empty() ? nullptr : commandMap.data());
+		counterSSBO = createBuffer(sizeof(CullCounters), nullptr);
+		for (int i = 0; i < COUNTER_LATENCY; i++) counterReadback[i] = createBuffer(sizeof(CullCounters), nullptr);
+
+		// Every slot starts unused
+		GLuint zero = 0;
+		glClearNamedBufferData(infoSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		glClearNamedBufferData(commandBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		glClearNamedBufferData(treeCountSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		for (int i = 0; i < COUNTER_LATENCY; i++) glClearNamedBufferData(counterReadback[i], GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	}
+
+	~OcclusionCuller() {
+		hiZ.destroy();
+		GLuint buffers[] = { infoSSBO, commandBuffer, treeSourceSSBO, treeVisibleSSBO, treeCountSSBO, treeCommandMapSSBO, counterSSBO };
+		glDeleteBuffers(sizeof(buffers) / sizeof(buffers[0]), buffers);
+		glDeleteBuffers(COUNTER_LATENCY, counterReadback);
+		delete cullCS;
+	}
+
+	// Terrain and grass of a freshly built chunk. bounds are the tight terrain bounds.
+	void RegisterChunk(int slot, const vec3& origin, float chunkSize, const AABB& bounds, GLuint vertexCount, const GrassField* grass) {
+		ChunkCullInfo info = {};
+		info.boundsMin = vec4(bounds.min.x, bounds.min.y, bounds.min.z, 0.0f);
+		info.boundsMax = vec4(bounds.max.x, bounds.max.y, bounds.max.z, 0.0f);
+		info.origin = vec4(origin.x, origin.y, origin.z, chunkSize);
+		info.terrainVertexCount = vertexCount;
+		if (grass) {
+			info.grassTileCapacity = grass->tileCapacity;
+			for (int t = 0; t < GRASS_TILES; t++) {
+				info.grassTileCount[t] = grass->tileCount[t];
+				info.grassTileHeight[t] = vec2(grass->tileMinY[t], grass->tileMaxY[t]);
+			}
+		}
+		glNamedBufferSubData(infoSSBO, GLintptr(slot) * sizeof(ChunkCullInfo), sizeof(ChunkCullInfo), &info);
+
+		// Static parts of the slot's commands; instanceCounts are written by the cull pass
+		std::vector<uint8_t> cmds(slotStride, 0);
+		DrawArraysIndirectCommand terrain = { vertexCount, 0u, 0u, 0u };
+		memcpy(cmds.data(), &terrain, sizeof(terrain));
+		for (int t = 0; t < GRASS_TILES; t++) {
+			DrawArraysIndirectCommand tile = { 3u, 0u, 0u, GLuint(t) * info.grassTileCapacity };
+			memcpy(cmds.data() + (1 + t) * sizeof(DrawArraysIndirectCommand), &tile, sizeof(tile));
+		}
+		for (const TreeCommand& c : treeCommands) {
+			GLuint baseInstance = (GLuint(slot) * treeVariants + c.variant) * treeCapacity;
+			if (c.indexed) {
+				DrawElementsIndirectCommand cmd = { c.range.count, 0u, c.range.first, c.range.baseVertex, baseInstance };
+				memcpy(cmds.data() + c.offset, &cmd, sizeof(cmd));
+			}
+			else {
+				DrawArraysIndirectCommand cmd = { c.range.count, 0u, c.range.first, baseInstance };
+				memcpy(cmds.data() + c.offset, &cmd, sizeof(cmd));
+			}
+		}
+		glNamedBufferSubData(commandBuffer, SlotOffset(slot), slotStride, cmds.data());
+	}
+
+	// Copy a chunk's scattered trees (treeCapacity slots per variant) into the cull source
+	void RegisterTrees(int slot, GLuint instanceBuffer, GLuint countBuffer) {
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		const GLsizeiptr instances = GLsizeiptr(treeVariants) * treeCapacity;
+		glCopyNamedBufferSubData(instanceBuffer, treeSourceSSBO, 0, GLintptr(slot) * instances * sizeof(PackedInstance), instances * sizeof(PackedInstance));
+		glCopyNamedBufferSubData(countBuffer, treeCountSSBO, 0, GLintptr(slot) * treeVariants * sizeof(GLuint), treeVariants * sizeof(GLuint));
+	}
+
+	void UnregisterChunk(int slot) {
+		ChunkCullInfo info = {};
+		glNamedBufferSubData(infoSSBO, GLintptr(slot) * sizeof(ChunkCullInfo), sizeof(ChunkCullInfo), &info);
+	}
+
+	// Camera pass visibility, before any camera draw of the frame
+	void Cull(const RenderState& state) {
+		glUseProgram(cullCS->getId());
+
+		FrustumPlanes planes = frustumPlanesFromVP(state.P * state.V);
+		cullCS->setUniform(enabled ? 1 : 0, "u_enabled");
+		cullCS->setVec4Array(planes.data(), 6, "u_planes");
+		cullCS->setUniform(hiZ.viewProj, "u_prevVP");
+		cullCS->setUniform(hiZ.valid ? 1 : 0, "u_hiZValid");
+		cullCS->setIVec2(hiZ.width, hiZ.height, "u_hiZSize");
+		cullCS->setUniform(hiZ.levels, "u_hiZLevels");
+		cullCS->setUniform(state.nearPlane, "u_nearPlane");
+		cullCS->setUniform((int)slotStride, "u_slotStride");
+		cullCS->setUniform(treeVariants, "u_treeVariants");
+		cullCS->setUniform(treeCapacity, "u_treeCapacity");
+		cullCS->setUniform((int)treeCommands.size(), "u_treeCommandCount");
+		cullCS->setVec4Array(treeSpheres.data(), MAX_TREE_VARIANTS, "u_treeSpheres");
+		cullCS->setUniform(vegetationReach, "u_vegetationReach");
+
+		GLuint zero = 0;
+		glClearNamedBufferData(counterSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, infoSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, treeSourceSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, treeVisibleSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, treeCountSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, treeCommandMapSSBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, counterSSBO);
+		glActiveTexture(GL_TEXTURE7);
+		glBindTexture(GL_TEXTURE_2D, hiZ.texture);
+
+		cullCS->Dispatch(maxSlots);
+
+		// Counters come back a few frames late so reading them never waits on the GPU
+		glCopyNamedBufferSubData(counterSSBO, counterReadback[frame % COUNTER_LATENCY], 0, 0, sizeof(CullCounters));
+		frame++;
+		glGetNamedBufferSubData(counterReadback[frame % COUNTER_LATENCY], 0, sizeof(CullCounters), &counters);
+	}
+
+	// Depth of the frame just rendered, tested against by the next Cull()
+	void BuildHiZ(GLuint depthTex, int width, int height, const mat4& viewProj) {
+		if (hiZ.width != max(1, (width + 1) / 2) || hiZ.height != max(1, (height + 1) / 2)) hiZ.create(width, height);
+		hiZ.build(depthTex, width, height, viewProj);
+	}
+
+	// Getters
+	GLuint getCommandBuffer() const { return commandBuffer; }
+	GLuint getVisibleTrees() const { return treeVisibleSSBO; }
+	GLintptr SlotOffset(int slot) const { return GLintptr(slot) * slotStride; }
+	GLintptr GrassCommandOffset(int slot) const { return SlotOffset(slot) + sizeof(DrawArraysIndirectCommand); }
+	GLintptr TreeCommandOffset(int slot, TreeBatch batch) const { return SlotOffset(slot) + treeBatchOffset[batch]; }
+	float getVegetationReach() const { return vegetationReach; }
+	const CullCounters& getCounters() const { return counters; }
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+private:
+	static GLuint createBuffer(GLsizeiptr size, const void* data) {
+		GLuint buffer = 0;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+		return buffer;
+	}
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "computeshader.h"
+#include "StreamBuffer.h"
+
+// Spawn counts per emitter, their prefix sum and one free-list claim for all of them.
+// Writes the indirect dispatch of ParticleEmitCS.
+class ParticleAllocCS : public ComputeShader {
+public:
+    ParticleAllocCS() {
+        create("particle_alloc.comp");
+    }
+
+    void Dispatch(float dt, GLuint freeListSSBO, const StreamBuffer::Range& emitters, GLuint spawnSSBO) {
+        glUseProgram(getId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, freeListSSBO);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, emitters.buffer, emitters.offset, emitters.size);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, spawnSSBO);
+
+        setUniform(dt, "u_dt");
+
+        // Single workgroup, one thread per emitter
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "computeshader.h"
+#include "StreamBuffer.h"
 
 class ParticleEmitCS : public ComputeShader {
 public:
@@ -7,22 +8,19 @@ public:
         create("particle_emit.comp");
     }
 
-    void Dispatch(float time, float dt, int emitterCount, GLuint particleSSBO, GLuint freeListSSBO, GLuint emittersSSBO) {
+    // spawnSSBO: ranges and dispatch size from ParticleAllocCS
+    void Dispatch(float time, GLuint particleSSBO, GLuint freeListSSBO, const StreamBuffer::Range& emitters, GLuint spawnSSBO) {
         glUseProgram(getId());
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleSSBO);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, freeListSSBO);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, emittersSSBO);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, emitters.buffer, emitters.offset, emitters.size);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, spawnSSBO);
 
         setUniform(time, "u_time");
-        setUniform(dt, "u_dt");
 
-        // Write emitter count into SSBO
-        glNamedBufferSubData(emittersSSBO, 0, sizeof(int), &emitterCount);
-
-        // Dispatch one workgroup per emitter
-        const GLuint localSize = 128;
-        GLuint groups = (emitterCount + localSize - 1) / localSize;
-        glDispatchCompute(groups, 1, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        // Dispatch one thread per spawned particle
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, spawnSSBO);
+        glDispatchComputeIndirect(0);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 };
@@ -7,7 +7,7 @@ class ParticleShader : public Shader {
 
 public:
 	ParticleShader() {
-		create("particle.vert", "particle.frag", "fragmentColor", "particle.geom");
+		create("particle.vert", "particle.frag", "fragmentColor");
 	}
 
 	void Bind(RenderState state) {
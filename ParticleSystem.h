@@ -2,7 +2,12 @@
 #include "framework.h"
 #include "ParticleShader.h"
 #include "ParticleUpdateCS.h"
+#include "ParticleAllocCS.h"
 #include "ParticleEmitCS.h"
+#include "camera.h"
+#include "GpuTimer.h"
+#include "RadixSort.h"
+#include "StreamBuffer.h"
 
 struct Particle {
 	vec4 pos;
@@ -18,44 +23,90 @@ struct Emitter {
 	vec4 color;
 };
 
+// What a particle does when it hits the depth buffer or the bedrock. Matches RESPONSE_* in particle_update.comp.
+enum ParticleResponse {
+	PARTICLE_BOUNCE,
+	PARTICLE_STICK,
+	PARTICLE_KILL,
+};
+
+// Draw of the live particles the update pass appended this frame, one 4-vertex strip instance each.
+// Matches the DrawCommand block in particle_update.comp.
+struct ParticleDrawCommand {
+	GLuint vertexCount;     // DrawArraysIndirectCommand
+	GLuint instanceCount;   // live particles
+	GLuint first;
+	GLuint baseInstance;
+};
+
+// Emission ranges from particle_alloc.comp, followed by emitterOffset[maxEmitters + 1].
+// Matches the Spawn block in particle_alloc.comp and particle_emit.comp.
+struct SpawnHeader {
+	GLuint groupsX;         // DispatchIndirectCommand of the emit pass
+	GLuint groupsY;
+	GLuint groupsZ;
+	GLuint spawnTotal;
+	GLuint freeBase;
+};
+
 class ParticleSystem {
+	static constexpr int COUNTER_LATENCY = 4;   // frames between a draw and reading its alive count
+
 	GLuint vao = 0;
 	GLuint particleSSBO = 0;
 	GLuint freeListSSBO = 0;
-	GLuint emittersSSBO = 0;
+	GLuint drawSSBO = 0;        // ParticleDrawCommand
+	GLuint aliveSSBO = 0;       // one particle index per live particle
+	GLuint keySSBO = 0;         // depth sort key per alive entry
+	GLuint spawnSSBO = 0;       // SpawnHeader, then the emitter offsets
+	GLuint aliveReadback[COUNTER_LATENCY] = {};
+	int frame = 0;
 
 	uint32_t count = 0;
 	const int maxEmitters = 64;
-	const int maxParticles = 65536;
+	const int maxParticles = 1 << 20;
+
+	StreamBuffer* stream;       // emitters and the alive-list reset
 
 	ParticleShader* particleShader;
 	ParticleUpdateCS* particleUpdateCS;
+	ParticleAllocCS* particleAllocCS;
 	ParticleEmitCS* particleEmitCS;
 
-	std::vector<Particle> particles;
 	std::vector<Emitter> emitters;
 
 public:
-	ParticleSystem() {
+	bool frustumCull = true;    // only visible particles go to the alive list
+	GLuint aliveCount = 0;      // drawn COUNTER_LATENCY frames ago
+	float ambientRate = 5000.0f; // ambient spawns per second; rate * 20 s life is the steady-state count
+	GpuTimer drawTimer;
+	GpuTimer emitTimer;         // allocation + emission
+	bool depthSort = true;      // draw back to front
+	RadixSort sorter;
+	bool collideDepth = true;   // against last frame's scene depth
+	bool collideBedrock = true; // against the analytic bedrock floor, also off screen
+	int response[2] = { PARTICLE_BOUNCE, PARTICLE_STICK }; // per type: ambient, trail
+	GpuTimer updateTimer;       // integration, collision and alive list
+
+	ParticleSystem(StreamBuffer* stream) : stream(stream) {
 		particleShader = new ParticleShader();
 		particleUpdateCS = new ParticleUpdateCS();
+		particleAllocCS = new ParticleAllocCS();
 		particleEmitCS = new ParticleEmitCS();
-
-		// Init particles
-		particles.reserve(maxParticles);
-		for (int i = 0; i < maxParticles; ++i) {
-			Particle p;
-			particles.push_back(p);
-		}
-		count = particles.size();
+		count = maxParticles;
+		drawTimer.init();
+		emitTimer.init();
+		updateTimer.init();
 
 		// VAO
 		glGenVertexArrays(1, &vao);
 
-		// Particle SSBO
+		// Particle SSBO, all dead (zero lifetime)
+		const GLuint zero = 0;
 		glGenBuffers(1, &particleSSBO);
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleSSBO);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, particles.size() * sizeof(Particle), particles.data(), GL_DYNAMIC_DRAW);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(count) * sizeof(Particle), nullptr, GL_DYNAMIC_DRAW);
+		glClearNamedBufferData(particleSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleSSBO);
 
 		// Freelist - start full of all indices
@@ -63,14 +114,30 @@ public:
 		glBindBuffer(GL_SHADER_STORAGE_BUFFER, freeListSSBO);
 		std::vector<uint32_t> freeIndices(count + 1);
 		freeIndices[0] = count; // every particle is initially free
-		for (uint32_t i = 0; i < count - 1; i++) freeIndices[i + 1] = i;
+		for (uint32_t i = 0; i < count; i++) freeIndices[i + 1] = i;
 		glBufferData(GL_SHADER_STORAGE_BUFFER, freeIndices.size() * sizeof(uint32_t), freeIndices.data(), GL_DYNAMIC_DRAW);
 
-		// Emitters
-		glGenBuffers(1, &emittersSSBO);
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, emittersSSBO);
-		size_t header = 16;
-		glBufferData(GL_SHADER_STORAGE_BUFFER, header + maxEmitters * sizeof(Emitter), nullptr, GL_DYNAMIC_DRAW);
+		// Alive list and its sort keys, rebuilt by every update
+		glGenBuffers(1, &drawSSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ParticleDrawCommand), nullptr, GL_DYNAMIC_DRAW);
+		glGenBuffers(1, &aliveSSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, aliveSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(count) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		glGenBuffers(1, &keySSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, keySSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(count) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+		sorter.create(count);
+		glGenBuffers(COUNTER_LATENCY, aliveReadback);
+		for (int i = 0; i < COUNTER_LATENCY; i++) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, aliveReadback[i]);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), &zero, GL_DYNAMIC_READ);
+		}
+
+		// Spawn ranges, written on the GPU every frame
+		glGenBuffers(1, &spawnSSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, spawnSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SpawnHeader) + (maxEmitters + 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
 	}
 
 	void AddEmitter(const vec3& center, const vec3& direction, float spreadAngle, float radius, float particleLife, float particleSize, float particleType, vec4 particleColor, float ratePerSec) {
@@ -82,15 +149,32 @@ public:
 		emitters.push_back(e);
 	}
 
-	void UploadEmitters() {
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, emittersSSBO);
+	// Emitters block of particle_alloc.comp: count, padded to 16 bytes, then the emitters
+	StreamBuffer::Range UploadEmitters() {
+		if ((int)emitters.size() > maxEmitters) emitters.resize(maxEmitters);
+		GLuint emitterCount = (GLuint)emitters.size();
 		const size_t header = 16;
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, header, emitters.size() * sizeof(Emitter), emitters.data());
+		StreamBuffer::Range range = stream->alloc(header + emitters.size() * sizeof(Emitter));
+		memcpy(range.ptr, &emitterCount, sizeof(GLuint));
+		if (!emitters.empty()) memcpy(range.ptr + header, emitters.data(), emitters.size() * sizeof(Emitter));
+		return range;
 	}
 
-	void Update(float time, float dt, const vec3& playerPos, const vec3& playerForward) {
+	// planes, cameraPos: camera for this frame's draw. prevDepth: last frame's scene depth drawn with prevViewProj, 0 if none yet
+	void Update(float time, float dt, const vec3& playerPos, const vec3& playerForward, const FrustumPlanes& planes, const vec3& cameraPos, GLuint prevDepth, const mat4& prevViewProj) {
 		emitters.clear();
-		particleUpdateCS->Dispatch(dt, count, particleSSBO, freeListSSBO);
+
+		// Empty alive list: one billboard strip, no instances yet
+		const ParticleDrawCommand command = { 4u, 0u, 0u, 0u };
+		StreamBuffer::Range reset = stream->upload(&command, sizeof(command));
+		glCopyNamedBufferSubData(reset.buffer, drawSSBO, reset.offset, 0, sizeof(command));
+		updateTimer.begin();
+		particleUpdateCS->SetCollision((collideDepth ? 1 : 0) | (collideBedrock ? 2 : 0), response, prevDepth, prevViewProj);
+		particleUpdateCS->Dispatch(dt, count, particleSSBO, freeListSSBO, drawSSBO, aliveSSBO, keySSBO, frustumCull, planes, cameraPos);
+		updateTimer.end();
+
+		// Farthest first, so alpha blending composites in order
+		if (depthSort) sorter.run(keySSBO, aliveSSBO, drawSSBO, offsetof(ParticleDrawCommand, instanceCount));
 
 		// Params
 		vec3 up = vec3(0.0f, 1.0f, 0.0f);
@@ -98,17 +182,20 @@ public:
 		vec3 heightOffset = vec3(0.0f, -1.0f, 0.0f);
 		
 		// Ambient
-		AddEmitter(playerPos, up, M_PI, 500.0f, 20.0f, 0.4f, 0.0f, vec4(0.85f, 0.8f, 0.7f, 0.3f), 5000.0f);
+		AddEmitter(playerPos, up, M_PI, 500.0f, 20.0f, 0.4f, 0.0f, vec4(0.85f, 0.8f, 0.7f, 0.3f), ambientRate);
 
 		// Trail
 		AddEmitter(playerPos + right + heightOffset, -playerForward, 0.0f, 0.0f, 10.0f, 0.5f, 1.0f, vec4(1.0f, 0.9f, 0.4f, 0.85f), 2000.0f);
 		AddEmitter(playerPos - right + heightOffset, -playerForward, 0.0f, 0.0f, 10.0f, 0.5f, 1.0f, vec4(1.0f, 0.9f, 0.4f, 0.85f), 2000.0f);
 
-		// Upload to SSBO
-		UploadEmitters();
+		// Upload to the frame's stream memory
+		StreamBuffer::Range emitterRange = UploadEmitters();
 
-		// Dispatch
-		particleEmitCS->Dispatch(time, dt, emitters.size(), particleSSBO, freeListSSBO, emittersSSBO);
+		// Dispatch: claim free slots for every emitter at once, then one thread per new particle
+		emitTimer.begin();
+		particleAllocCS->Dispatch(dt, freeListSSBO, emitterRange, spawnSSBO);
+		particleEmitCS->Dispatch(time, particleSSBO, freeListSSBO, emitterRange, spawnSSBO);
+		emitTimer.end();
 	}
 	
 	void Draw(RenderState& state) {
@@ -116,15 +203,35 @@ public:
 
 		glBindVertexArray(vao);
 		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleSSBO);
-		glDrawArrays(GL_POINTS, 0, count);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, aliveSSBO);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawSSBO);
+		drawTimer.begin();
+		glDrawArraysIndirect(GL_TRIANGLE_STRIP, (void*)0);
+		drawTimer.end();
+
+		// Alive count comes back a few frames late so reading it never waits on the GPU
+		glCopyNamedBufferSubData(drawSSBO, aliveReadback[frame % COUNTER_LATENCY], offsetof(ParticleDrawCommand, instanceCount), 0, sizeof(GLuint));
+		frame++;
+		glGetNamedBufferSubData(aliveReadback[frame % COUNTER_LATENCY], 0, sizeof(GLuint), &aliveCount);
 	}
 
+	int getMaxParticles() const { return maxParticles; }
+
 	~ParticleSystem() {
-		if (emittersSSBO) glDeleteBuffers(1, &emittersSSBO);
+		drawTimer.destroy();
+		emitTimer.destroy();
+		updateTimer.destroy();
+		sorter.destroy();
+		if (spawnSSBO) glDeleteBuffers(1, &spawnSSBO);
+		if (keySSBO) glDeleteBuffers(1, &keySSBO);
+		if (aliveSSBO) glDeleteBuffers(1, &aliveSSBO);
+		if (drawSSBO) glDeleteBuffers(1, &drawSSBO);
+		glDeleteBuffers(COUNTER_LATENCY, aliveReadback);
 		if (freeListSSBO) glDeleteBuffers(1, &freeListSSBO);
 		if (particleSSBO) glDeleteBuffers(1, &particleSSBO);
 		if (vao) glDeleteVertexArrays(1, &vao);
 		delete particleEmitCS;
+		delete particleAllocCS;
 		delete particleUpdateCS;
 		delete particleShader;
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include "computeshader.h"
+#include "camera.h"
 
 class ParticleUpdateCS : public ComputeShader {
 public:
@@ -7,18 +8,42 @@ public:
         create("particle_update.comp");
     }
 
-    void Dispatch(float dt, int count, GLuint particleSSBO, GLuint freeListSSBO) {
+    // Collision for the next Dispatch. collide: COLLIDE_* bits of particle_update.comp, response: ParticleResponse
+    // per type, prevDepth: last frame's scene depth drawn with prevViewProj (0 = no depth collision)
+    void SetCollision(int collide, const int response[2], GLuint prevDepth, const mat4& prevViewProj) {
+        glUseProgram(getId());
+        if (!prevDepth) collide &= ~1;
+        setUniform(collide, "u_collide");
+        int location = glGetUniformLocation(getId(), "u_response");
+        if (location >= 0) glUniform1iv(location, 2, response);
+        setUniform(prevViewProj, "u_prevVP");
+        setUniform(Inverse(prevViewProj), "u_prevInvVP");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, prevDepth);
+    }
+
+    // Live particles are appended to aliveSSBO (inside the frustum only, with cull), counted in drawSSBO,
+    // with a back-to-front sort key from cameraPos in keySSBO
+    void Dispatch(float dt, int count, GLuint particleSSBO, GLuint freeListSSBO, GLuint drawSSBO, GLuint aliveSSBO, GLuint keySSBO, bool cull, const FrustumPlanes& planes, const vec3& cameraPos) {
         glUseProgram(getId());
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particleSSBO);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, freeListSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, drawSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, aliveSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, keySSBO);
 
         setUniform(dt, "u_dt");
         setUniform(count, "u_count");
+        setUniform(cull ? 1 : 0, "u_frustumCull");
+        setUniform(cameraPos, "u_cameraPos");
+        int location = glGetUniformLocation(getId(), "u_planes");
+        if (location >= 0) glUniform4fv(location, 6, &planes[0].x);
 
         // Dispatch
         const GLuint localSize = 256;
         GLuint groups = (count + localSize - 1) / localSize;
         glDispatchCompute(groups, 1, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
     }
 };
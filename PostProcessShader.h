@@ -12,6 +12,9 @@ public:
 		
 		setUniform(0, "u_sceneColor");
 		setUniform(1, "u_sceneDepth");
+		setUniform(2, "u_bloom");
+		setUniform(3, "u_dofBlur");
+		setUniform(4, "u_dofTiles");
 		setUniform(state.nearPlane, "u_near");
 		setUniform(state.farPlane, "u_far");
 		
@@ -19,9 +22,7 @@ public:
 		setUniform(state.focusDist, "u_focusDist");
 		setUniform(state.focusRange, "u_focusRange");
 
-		// Bloom
-		setUniform(state.bloomThreshold, "u_bloomThreshold");
-		setUniform(state.bloomSoftKnee, "u_bloomSoftKnee");
+		// Bloom (threshold and knee are applied by the bloom chain)
 		setUniform(state.bloomIntensity, "u_bloomIntensity");
 
 		// Color grading
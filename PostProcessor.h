@@ -3,10 +3,20 @@
 #include "shader.h"
 #include "PostProcessShader.h"
 #include "RenderState.h"
+#include "Bloom.h"
+#include "DepthOfField.h"
+#include "GpuTimer.h"
 
 class PostProcessor {
     GLuint fsVAO = 0, fsVBO = 0;
     PostProcessShader* shader = nullptr;
+    GpuTimer compositeTimer;
+
+public:
+    Bloom bloom;
+    DepthOfField dof;
+
+private:
 
     void createFullscreenTriangle() {
         if (fsVAO) return;
@@ -31,32 +41,58 @@ public:
     void init() {
         shader = new PostProcessShader();
         createFullscreenTriangle();
+        compositeTimer.init();
     }
 
     void destroy() {
         if (fsVBO) { glDeleteBuffers(1, &fsVBO); fsVBO = 0; }
         if (fsVAO) { glDeleteVertexArrays(1, &fsVAO); fsVAO = 0; }
         if (shader) { delete shader; shader = nullptr; }
+        bloom.destroy();
+        dof.destroy();
+        compositeTimer.destroy();
     }
 
     // Runs post-process on default framebuffer
     void run(const RenderState& state, GLuint sceneColor, GLuint sceneDepth, int width, int height) {
+        // Bloom chain at half resolution and below
+        if (bloom.screenW != width || bloom.screenH != height) bloom.create(width, height);
+        bloom.run(sceneColor, state.bloomThreshold, state.bloomSoftKnee);
+
+        // Depth of field tiles and half-res gather
+        if (dof.screenW != width || dof.screenH != height) dof.create(width, height);
+        dof.run(state, sceneColor, sceneDepth);
+
+        compositeTimer.begin();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glViewport(0, 0, width, height);
 
         shader->Bind(state);
+        shader->setUniform(bloom.levels, "u_bloomLevels");
 
         // sceneColor = 0
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, sceneColor);
-        glGenerateMipmap(GL_TEXTURE_2D); // generate lower mips for Bloom
 
         // sceneDepth = 1
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, sceneDepth);
 
+        // bloom = 2
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, bloom.result());
+
+        // dofBlur = 3, dofTiles = 4
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, dof.blur);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, dof.tiles);
+
         glBindVertexArray(fsVAO);
         glDrawArrays(GL_TRIANGLES, 0, 3);
         glBindVertexArray(0);
+        compositeTimer.end();
     }
+
+    float getCompositeMs() const { return compositeTimer.getMs(); }
 };
@@ -0,0 +1,23 @@
+#pragma once
+#include "computeshader.h"
+
+class RadixHistogramCS : public ComputeShader {
+public:
+    RadixHistogramCS() {
+        create("radix_histogram.comp");
+    }
+
+    // Per-block counts of the 8-bit digit at shift
+    void Dispatch(GLuint keys, GLuint histogramSSBO, GLuint paramsSSBO, int shift, int blocks) {
+        glUseProgram(getId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keys);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, histogramSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, paramsSSBO);
+
+        setUniform(shift, "u_shift");
+
+        // Blocks past the live count return at once
+        glDispatchCompute(blocks, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+};
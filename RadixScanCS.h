@@ -0,0 +1,19 @@
+#pragma once
+#include "computeshader.h"
+
+class RadixScanCS : public ComputeShader {
+public:
+    RadixScanCS() {
+        create("radix_scan.comp");
+    }
+
+    void Dispatch(GLuint histogramSSBO, GLuint paramsSSBO) {
+        glUseProgram(getId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, histogramSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, paramsSSBO);
+
+        // Single workgroup
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "computeshader.h"
+
+class RadixScatterCS : public ComputeShader {
+public:
+    RadixScatterCS() {
+        create("radix_scatter.comp");
+    }
+
+    // Stable move of (key, value) pairs to their scanned slots for the digit at shift
+    void Dispatch(GLuint keysIn, GLuint valuesIn, GLuint keysOut, GLuint valuesOut, GLuint histogramSSBO, GLuint paramsSSBO, int shift, int blocks) {
+        glUseProgram(getId());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, keysIn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, valuesIn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, keysOut);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, valuesOut);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, histogramSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, paramsSSBO);
+
+        setUniform(shift, "u_shift");
+
+        glDispatchCompute(blocks, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+};
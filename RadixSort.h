@@ -0,0 +1,93 @@
+#pragma once
+#include "framework.h"
+#include "RadixHistogramCS.h"
+#include "RadixScanCS.h"
+#include "RadixScatterCS.h"
+#include "GpuTimer.h"
+
+// Stable GPU sort of (uint key, uint value) pairs by ascending key, in place in the caller's buffers.
+// Four 8-bit LSD passes ping-pong through scratch buffers and end back in the input. The count can
+// come from a GPU buffer (e.g. an append counter) so nothing waits on a readback.
+struct RadixSort {
+	static constexpr int BLOCK_SIZE = 256 * 16;  // keys per workgroup, matches BLOCK_SIZE in radix_*.comp
+	static constexpr int PASSES = 4;
+
+	GLuint tempKeys = 0;
+	GLuint tempValues = 0;
+	GLuint histogram = 0;   // 256 digits x blocks
+	GLuint params = 0;      // uint count
+	int capacity = 0;
+	int maxBlocks = 0;
+
+	RadixHistogramCS* histogramCS = nullptr;
+	RadixScanCS* scanCS = nullptr;
+	RadixScatterCS* scatterCS = nullptr;
+	GpuTimer timer;
+
+	void create(int maxKeys) {
+		destroy();
+		capacity = maxKeys;
+		maxBlocks = max(1, (maxKeys + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+		tempKeys = createBuffer(GLsizeiptr(capacity) * sizeof(GLuint));
+		tempValues = createBuffer(GLsizeiptr(capacity) * sizeof(GLuint));
+		histogram = createBuffer(GLsizeiptr(256) * maxBlocks * sizeof(GLuint));
+		params = createBuffer(sizeof(GLuint));
+
+		histogramCS = new RadixHistogramCS();
+		scanCS = new RadixScanCS();
+		scatterCS = new RadixScatterCS();
+		timer.init();
+	}
+
+	// Sorts the first count pairs, count known on the CPU
+	void run(GLuint keys, GLuint values, GLuint count) {
+		count = min(count, (GLuint)capacity);
+		glNamedBufferSubData(params, 0, sizeof(GLuint), &count);
+		sort(keys, values);
+	}
+
+	// Sorts as many pairs as the uint at countOffset in countBuffer says (at most capacity)
+	void run(GLuint keys, GLuint values, GLuint countBuffer, GLintptr countOffset) {
+		glCopyNamedBufferSubData(countBuffer, params, countOffset, 0, sizeof(GLuint));
+		sort(keys, values);
+	}
+
+	void destroy() {
+		GLuint buffers[] = { tempKeys, tempValues, histogram, params };
+		for (GLuint b : buffers) if (b) glDeleteBuffers(1, &b);
+		tempKeys = tempValues = histogram = params = 0;
+		if (histogramCS) { delete histogramCS; histogramCS = nullptr; }
+		if (scanCS) { delete scanCS; scanCS = nullptr; }
+		if (scatterCS) { delete scatterCS; scatterCS = nullptr; }
+		timer.destroy();
+		capacity = maxBlocks = 0;
+	}
+
+private:
+	void sort(GLuint keys, GLuint values) {
+		timer.begin();
+		for (int pass = 0; pass < PASSES; pass++) {
+			// Even passes read the caller's buffers, odd passes the scratch ones
+			bool fromInput = pass % 2 == 0;
+			GLuint keysIn = fromInput ? keys : tempKeys;
+			GLuint valuesIn = fromInput ? values : tempValues;
+			GLuint keysOut = fromInput ? tempKeys : keys;
+			GLuint valuesOut = fromInput ? tempValues : values;
+			int shift = 8 * pass;
+
+			histogramCS->Dispatch(keysIn, histogram, params, shift, maxBlocks);
+			scanCS->Dispatch(histogram, params);
+			scatterCS->Dispatch(keysIn, valuesIn, keysOut, valuesOut, histogram, params, shift, maxBlocks);
+		}
+		timer.end();
+	}
+
+	static GLuint createBuffer(GLsizeiptr size) {
+		GLuint buffer = 0;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+		return buffer;
+	}
+};
@@ -1,47 +1,83 @@
 #pragma once
 #include "framework.h"
 
+// Color + depth framebuffer. With pingPong it holds two sets that swap roles every frame: fbo/color/depth
+// are drawn this frame, prevColor/prevDepth hold last frame's result and can be sampled meanwhile.
 struct RenderTarget {
     GLuint fbo = 0;
     GLuint color = 0;
     GLuint depth = 0;
+    GLuint prevColor = 0;
+    GLuint prevDepth = 0;
     int width = 0, height = 0;
 
+private:
+    GLuint fbos[2] = {}, colors[2] = {}, depths[2] = {};
+    int sets = 1;
+    int current = 0;
+
+public:
     void destroy() {
-        if (depth) { glDeleteTextures(1, &depth); depth = 0; }
-        if (color) { glDeleteTextures(1, &color); color = 0; }
-        if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; }
+        glDeleteTextures(2, depths);
+        glDeleteTextures(2, colors);
+        glDeleteFramebuffers(2, fbos);
+        for (int i = 0; i < 2; i++) fbos[i] = colors[i] = depths[i] = 0;
+        fbo = color = depth = prevColor = prevDepth = 0;
         width = height = 0;
     }
 
-    void create(int w, int h) {
+    void create(int w, int h, bool pingPong = false) {
         destroy();
         width = w; height = h;
+        sets = pingPong ? 2 : 1;
+        current = 0;
+
+        for (int i = 0; i < sets; i++) {
+            glGenFramebuffers(1, &fbos[i]);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbos[i]);
+
+            glGenTextures(1, &colors[i]);
+            glBindTexture(GL_TEXTURE_2D, colors[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colors[i], 0);
+
+            glGenTextures(1, &depths[i]);
+            glBindTexture(GL_TEXTURE_2D, depths[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, w, h, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depths[i], 0);
 
-        glGenFramebuffers(1, &fbo);
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-        glGenTextures(1, &color);
-        glBindTexture(GL_TEXTURE_2D, color);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
-
-        glGenTextures(1, &depth);
-        glBindTexture(GL_TEXTURE_2D, depth);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, w, h, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+            // The first frame reads the other set before anything was drawn into it
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        select();
+    }
+
+    // Start of a frame: last frame's set becomes prev, the other one is drawn
+    void swap() {
+        current = (current + 1) % sets;
+        select();
     }
 
     void bind() { glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
     void unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+private:
+    void select() {
+        int prev = (current + sets - 1) % sets;
+        fbo = fbos[current];
+        color = colors[current];
+        depth = depths[current];
+        prevColor = colors[prev];
+        prevDepth = depths[prev];
+    }
 };
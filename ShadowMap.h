@@ -1,26 +1,23 @@
 #pragma once
+#include "renderstate.h"
 
+// One depth layer per cascade, each rendered through its own light matrix.
+// Static casters are cached in staticTex; depthTex (sampled) is that plus dynamic casters.
 struct ShadowMap {
 	GLuint fbo = 0;
-	GLuint depthTex = 0;
+	GLuint depthTex = 0;  // GL_TEXTURE_2D_ARRAY
+	GLuint staticTex = 0; // GL_TEXTURE_2D_ARRAY
 	int width = 2048, height = 2048;
+	int cascades = SHADOW_CASCADES;
 
 	void init() {
 		glGenFramebuffers(1, &fbo);
 		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 
-		glGenTextures(1, &depthTex);
-		glBindTexture(GL_TEXTURE_2D, depthTex);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		float border[4] = {1.0f, 1.0f, 1.0f, 1.0f}; // treat outside as lit
-		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE); // manual filtering in shader
+		depthTex = createLayers();
+		staticTex = createLayers();
 
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTex, 0);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTex, 0, 0);
 		glDrawBuffer(GL_NONE);
 		glReadBuffer(GL_NONE);
 
@@ -30,8 +27,48 @@ struct ShadowMap {
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
+	// Bind the FBO with the given cascade as depth target
+	void bindCascade(int c) {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTex, 0, c);
+	}
+
+	void bindStatic(int c) {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticTex, 0, c);
+	}
+
+	// Reset a cascade to its cached static casters
+	void restoreStatic(int c) {
+		glCopyImageSubData(staticTex, GL_TEXTURE_2D_ARRAY, 0, 0, 0, c, depthTex, GL_TEXTURE_2D_ARRAY, 0, 0, 0, c, width, height, 1);
+	}
+
+	// Only the texel rect [x0, x1) x [y0, y1), e.g. where a dynamic caster was drawn
+	void restoreStatic(int c, const int rect[4]) {
+		int w = rect[2] - rect[0], h = rect[3] - rect[1];
+		if (w <= 0 || h <= 0) return;
+		glCopyImageSubData(staticTex, GL_TEXTURE_2D_ARRAY, 0, rect[0], rect[1], c, depthTex, GL_TEXTURE_2D_ARRAY, 0, rect[0], rect[1], c, w, h, 1);
+	}
+
 	void destroy() {
 		if (depthTex) { glDeleteTextures(1, &depthTex); depthTex = 0; }
+		if (staticTex) { glDeleteTextures(1, &staticTex); staticTex = 0; }
 		if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; }
 	}
-};
\ No newline at end of file
+
+private:
+	GLuint createLayers() {
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, width, height, cascades, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		float border[4] = {1.0f, 1.0f, 1.0f, 1.0f}; // treat outside as lit
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE); // manual filtering in shader
+		return tex;
+	}
+};
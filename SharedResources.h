@@ -3,22 +3,35 @@
 #include "shader.h"
 #include "MarchingCubesCS.h"
 #include "GroundDistanceCS.h"
+#include "TreeScatterCS.h"
+#include "ImpostorAtlas.h"
 #include "geometry.h"
+#include "OcclusionCuller.h"
+#include "StreamBuffer.h"
 
 struct SharedResources {
     // Shaders
     Shader*             terrainShader       = nullptr;
     Shader*             waterShader         = nullptr;
+    Shader*             waterSurfaceShader  = nullptr;
     Shader*             instanceShader      = nullptr;
     Shader*             treeTrunkShader     = nullptr;
     Shader*             treeLeafShader      = nullptr;
+    Shader*             treeImpostorShader  = nullptr;
     MarchingCubesCS*    marchingCubesCS     = nullptr;
     GroundDistanceCS*   groundDistanceCS    = nullptr;
-    TerrainHeightCS*    terrainHeightCS     = nullptr;
+    TreeScatterCS*      treeScatterCS       = nullptr;
 
     // common geometries
     Geometry* waterGeom     = nullptr;
     Geometry* cactusGeom    = nullptr;
     std::vector<Geometry*> treeTrunkGeoms;
     std::vector<Geometry*> treeCrownGeoms;
+    ImpostorAtlas*         treeImpostors = nullptr;
+
+    // GPU visibility of chunk contents, shared by every chunk slot
+    OcclusionCuller*       culler = nullptr;
+
+    // Per-frame uploads
+    StreamBuffer*          stream = nullptr;
 };
@@ -21,14 +21,14 @@ public:
 		state.MVP = state.P * state.V * state.M;
 		shader->Bind(state);
 
-		// Disable depth testing
+		// Drawn last at the far plane: only pixels nothing else covered pass
 		glDepthMask(GL_FALSE);
-		glDisable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LEQUAL);
 
 		geometry->Draw();
 
 		// Revert after drawing
-		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
 		glDepthMask(GL_TRUE);
 	}
 };
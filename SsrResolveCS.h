@@ -0,0 +1,37 @@
+#pragma once
+#include "computeshader.h"
+
+class SsrResolveCS : public ComputeShader {
+public:
+    SsrResolveCS() {
+        create("ssr_resolve.comp");
+    }
+
+    // Blends the bilateral-filtered trace with the reprojected history into dst
+    void Dispatch(GLuint surface, GLuint trace, GLuint history, GLuint dst, int halfW, int halfH, const mat4& invP, const mat4& reproject, bool historyValid, float feedback) {
+        glUseProgram(getId());
+
+        setIVec2(halfW, halfH, "u_halfSize");
+        setUniform(invP, "u_invP");
+        setUniform(reproject, "u_reproject");
+        setUniform(historyValid ? 1 : 0, "u_historyValid");
+        setUniform(feedback, "u_feedback");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, surface);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, trace);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, history);
+        glBindImageTexture(0, dst, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        glDispatchCompute((halfW + 7) / 8, (halfH + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
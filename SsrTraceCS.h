@@ -0,0 +1,46 @@
+#pragma once
+#include "computeshader.h"
+
+class SsrTraceCS : public ComputeShader {
+public:
+    SsrTraceCS() {
+        create("ssr_trace.comp");
+    }
+
+    // One thread per half-resolution pixel; counters gets water pixels and Hi-Z steps added
+    void Dispatch(GLuint surface, GLuint sceneDepth, GLuint prevColor, GLuint prevDepth, GLuint hiZ, int hiZLevels, GLuint dst, GLuint counters,
+                  int halfW, int halfH, int width, int height, const mat4& P, const mat4& invP, const mat4& reproject, float nearPlane, float farPlane) {
+        glUseProgram(getId());
+
+        setIVec2(halfW, halfH, "u_halfSize");
+        setIVec2(width, height, "u_size");
+        setUniform(hiZLevels, "u_hiZLevels");
+        setUniform(P, "u_P");
+        setUniform(invP, "u_invP");
+        setUniform(reproject, "u_reproject");
+        setUniform(nearPlane, "u_near");
+        setUniform(farPlane, "u_far");
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, surface);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, sceneDepth);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, prevColor);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, prevDepth);
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D, hiZ);
+        glBindImageTexture(0, dst, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, counters);
+
+        glDispatchCompute((halfW + 7) / 8, (halfH + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+
+private:
+    void setIVec2(int x, int y, const std::string& name) {
+        int location = glGetUniformLocation(getId(), name.c_str());
+        if (location >= 0) glUniform2i(location, x, y);
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include "framework.h"
+
+// Ring of persistently mapped memory for per-frame uploads (uniform blocks, emitters, small copies).
+// Each of the FRAMES regions is written by one frame and fenced at its end; the region is only reused
+// after the GPU passed that fence, so writes never wait on the driver or orphan a buffer.
+// Everything written into the ring is gone after FRAMES frames: bind it again every frame.
+// A frame that outgrows its region gets dedicated overflow buffers, freed once that frame's fence passed.
+struct StreamBuffer {
+	static constexpr int FRAMES = 3;
+	static constexpr GLsizeiptr FRAME_CAPACITY = 256 * 1024;
+
+	struct Range {
+		GLuint buffer = 0;
+		GLintptr offset = 0;
+		GLsizeiptr size = 0;
+		uint8_t* ptr = nullptr; // write-only, coherent
+	};
+
+	GLuint buffer = 0;
+	size_t bytesLastFrame = 0;  // uploaded by the last finished frame
+	int overflowed = 0;         // allocations that did not fit their region, since create
+	int waitsLastFrame = 0;     // fence waits that did not pass immediately
+
+private:
+	uint8_t* mapped = nullptr;
+	GLsync fences[FRAMES] = {};
+	int frame = 0;
+	GLintptr head = 0;
+	GLint alignment = 256;      // max of the UBO and SSBO offset alignments
+	std::vector<GLuint> overflow[FRAMES]; // per region, alive until its fence
+	size_t bytes = 0;
+	int waits = 0;
+
+public:
+	// Starts in frame 0, so uploads at load time work before the first beginFrame
+	void create() {
+		destroy();
+		GLint uboAlign = 0, ssboAlign = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssboAlign);
+		alignment = max(16, max(uboAlign, ssboAlign));
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, FRAMES * FRAME_CAPACITY, nullptr, flags);
+		mapped = (uint8_t*)glMapNamedBufferRange(buffer, 0, FRAMES * FRAME_CAPACITY, flags);
+		frame = 0;
+		head = 0;
+	}
+
+	// Moves to the next region, waiting for the frame that used it FRAMES frames ago
+	void beginFrame() {
+		frame++;
+		int region = frame % FRAMES;
+		if (fences[region]) {
+			GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (result == GL_TIMEOUT_EXPIRED) {
+				waits++;
+				while (result == GL_TIMEOUT_EXPIRED) result = glClientWaitSync(fences[region], 0, 1000000);
+			}
+			glDeleteSync(fences[region]);
+			fences[region] = 0;
+		}
+		releaseOverflow(region);
+		head = GLintptr(region) * FRAME_CAPACITY;
+	}
+
+	// Fences the region written since beginFrame (or since create)
+	void endFrame() {
+		int region = frame % FRAMES;
+		if (fences[region]) glDeleteSync(fences[region]);
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		bytesLastFrame = bytes;
+		waitsLastFrame = waits;
+		bytes = 0;
+		waits = 0;
+	}
+
+	// Uninitialized space in this frame's region, or in an overflow buffer when the region is full
+	Range alloc(GLsizeiptr size) {
+		GLintptr regionStart = GLintptr(frame % FRAMES) * FRAME_CAPACITY;
+		GLintptr offset = (head + alignment - 1) / alignment * alignment;
+		bytes += size_t(size);
+		if (offset + size > regionStart + FRAME_CAPACITY) return allocOverflow(size);
+		head = offset + size;
+
+		Range range;
+		range.buffer = buffer;
+		range.offset = offset;
+		range.size = size;
+		range.ptr = mapped + offset;
+		return range;
+	}
+
+	Range upload(const void* data, GLsizeiptr size) {
+		Range range = alloc(size);
+		memcpy(range.ptr, data, size_t(size));
+		return range;
+	}
+
+	// Uploads and binds to an indexed target (GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER)
+	Range bind(GLenum target, GLuint index, const void* data, GLsizeiptr size) {
+		Range range = upload(data, size);
+		glBindBufferRange(target, index, range.buffer, range.offset, range.size);
+		return range;
+	}
+
+	void destroy() {
+		for (int region = 0; region < FRAMES; region++) releaseOverflow(region);
+		for (GLsync& fence : fences) {
+			if (fence) glDeleteSync(fence);
+			fence = 0;
+		}
+		if (buffer) {
+			glUnmapNamedBuffer(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+		buffer = 0;
+		mapped = nullptr;
+	}
+
+private:
+	// Earlier ranges of the frame may still be read by queued draws, so the ring is never reused early
+	Range allocOverflow(GLsizeiptr size) {
+		if (overflowed == 0) printf("StreamBuffer: frame uploads exceed %lld bytes, raise FRAME_CAPACITY\n", (long long)FRAME_CAPACITY);
+		overflowed++;
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		Range range;
+		glCreateBuffers(1, &range.buffer);
+		glNamedBufferStorage(range.buffer, size, nullptr, flags);
+		range.ptr = (uint8_t*)glMapNamedBufferRange(range.buffer, 0, size, flags);
+		range.size = size;
+		overflow[frame % FRAMES].push_back(range.buffer);
+		return range;
+	}
+
+	void releaseOverflow(int region) {
+		for (GLuint b : overflow[region]) {
+			glUnmapNamedBuffer(b);
+			glDeleteBuffers(1, &b);
+		}
+		overflow[region].clear();
+	}
+};
@@ -1,37 +0,0 @@
-#pragma once
-#include "computeshader.h"
-
-class TerrainHeightCS : public ComputeShader {
-    GLuint distanceBuffer;
-
-public:
-    TerrainHeightCS() {
-        create("terrain_height.comp");
-
-        glGenBuffers(1, &distanceBuffer);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, distanceBuffer);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float), NULL, GL_DYNAMIC_DRAW);
-    }
-
-    void Dispatch(vec3 pos, float maxHeight, float& outGroundDist, GLuint segIndexSSBO, GLuint segIndexCount) {
-        glUseProgram(getId());
-
-        setUniform(pos, "pos");
-        setUniform(maxHeight, "maxHeight");
-        setUniform((int)segIndexCount, "u_segIndexCount");
-
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, distanceBuffer);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, segIndexSSBO);
-
-        glDispatchCompute(1, 1, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, distanceBuffer);
-        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float), &outGroundDist);
-    }
-
-
-    ~TerrainHeightCS() {
-        if (distanceBuffer) glDeleteBuffers(1, &distanceBuffer);
-    }
-};
@@ -0,0 +1,32 @@
+#pragma once
+#include "computeshader.h"
+
+class TreeScatterCS : public ComputeShader {
+public:
+    TreeScatterCS() {
+        create("tree_scatter.comp");
+    }
+
+    void Dispatch(vec3 chunkId, float chunkSize, uint32_t seed, float ratePerChunk, int maxPerChunk, int variantCount, int capacityPerVariant, float maxHeight, GLuint countSSBO, GLuint instanceSSBO, GLuint segIndexSSBO, GLuint segIndexCount) {
+        glUseProgram(getId());
+
+        setUniform(chunkId, "u_chunkId");
+        setUniform(chunkSize, "u_chunkSize");
+        setUniform((int)seed, "u_scatterSeed");
+        setUniform(ratePerChunk, "u_ratePerChunk");
+        setUniform(maxPerChunk, "u_maxPerChunk");
+        setUniform(variantCount, "u_variantCount");
+        setUniform(capacityPerVariant, "u_capacityPerVariant");
+        setUniform(maxHeight, "u_maxHeight");
+        setUniform((int)segIndexCount, "u_segIndexCount");
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, countSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instanceSSBO);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, segIndexSSBO);
+
+        const GLuint localSize = 64;
+        GLuint groups = (maxPerChunk + localSize - 1) / localSize;
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "framework.h"
+#include "trunk.h"
+#include "leaves.h"
+#include "MeshCache.h"
+#include <thread>
+#include <atomic>
+
+// Generator settings for the shared tree variants, all part of the cache key
+struct TreeVariantSettings {
+	int   variantCount  = 10;
+	float trunkScale    = 128.0f;
+	int   trunkTess     = 32;
+	float crownRadius   = 200.0f;
+	int   crownTess     = 64;
+	int   leafCount     = 3600;
+};
+
+struct TreeBuildStats {
+	float seconds = 0.0f;
+	int cached = 0;
+	int generated = 0;
+	std::vector<size_t> trunkLodTriangles; // summed over all variants
+};
+
+// Loads trunk and crown meshes from the cache, generates the missing ones on worker threads,
+// then uploads everything on the calling (GL) thread.
+inline TreeBuildStats BuildTreeVariants(const TreeVariantSettings& s, std::vector<Geometry*>& trunks, std::vector<Geometry*>& crowns) {
+	TreeBuildStats stats;
+	double t0 = glfwGetTime();
+
+	MeshCache cache;
+	const int N = s.variantCount;
+
+	// Jobs 0..N-1 are trunks (indexed, with LODs), N..2N-1 are crowns (one un-indexed mesh)
+	struct Job { std::string name; uint64_t key; bool hit; std::vector<IndexedMesh> meshes; };
+	std::vector<Job> jobs(2 * N);
+	for (int i = 0; i < N; i++) {
+		jobs[i].name		= "trunk" + std::to_string(i);
+		jobs[i].key			= MeshCache::key({ (float)i, s.trunkScale, (float)s.trunkTess, (float)TrunkGeometry::LOD_COUNT });
+		jobs[N + i].name	= "crown" + std::to_string(i);
+		jobs[N + i].key		= MeshCache::key({ (float)i, s.crownRadius, (float)s.crownTess, (float)s.leafCount });
+	}
+
+	std::atomic<int> next(0);
+	auto worker = [&]() {
+		for (int j = next++; j < 2 * N; j = next++) {
+			Job& job = jobs[j];
+			job.hit = cache.load(job.name, job.key, job.meshes);
+			if (job.hit) continue;
+
+			// Seed = variant index, same as TreeParams(i) in the sequential version
+			TreeParams params(uint32_t(j % N));
+			IndexedMesh mesh;
+			if (j < N) {
+				TrunkGeometry::generate(s.trunkScale, s.trunkTess, params, mesh.vtx, mesh.idx);
+				job.meshes = buildLods(mesh, TrunkGeometry::LOD_COUNT);
+			}
+			else {
+				LeavesGeometry::generate(s.crownRadius, s.crownTess, s.leafCount, params, mesh.vtx);
+				job.meshes = { mesh };
+			}
+			cache.store(job.name, job.key, job.meshes);
+		}
+	};
+
+	unsigned int threadCount = max(1u, min(std::thread::hardware_concurrency(), unsigned(2 * N)));
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < threadCount; t++) threads.emplace_back(worker);
+	worker();
+	for (auto& t : threads) t.join();
+
+	// GPU upload
+	for (int i = 0; i < N; i++) {
+		trunks.push_back(new TrunkGeometry(jobs[i].meshes));
+		crowns.push_back(new LeavesGeometry(jobs[N + i].meshes[0].vtx));
+
+		const auto& lods = jobs[i].meshes;
+		stats.trunkLodTriangles.resize(max(stats.trunkLodTriangles.size(), lods.size()), 0);
+		for (size_t l = 0; l < lods.size(); l++) stats.trunkLodTriangles[l] += lods[l].triangleCount();
+	}
+	for (const Job& job : jobs) (job.hit ? stats.cached : stats.generated)++;
+
+	stats.seconds = float(glfwGetTime() - t0);
+	printf("Tree variants: %.2f s (%d cached, %d generated, %u threads)\n", stats.seconds, stats.cached, stats.generated, threadCount);
+	printf("Trunk LOD triangles (all variants):");
+	for (size_t t : stats.trunkLodTriangles) printf(" %zu", t);
+	printf("\n");
+	return stats;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <functional>
+#include "framework.h"
+#include "RenderState.h"
+#include "HiZBuffer.h"
+#include "SsrTraceCS.h"
+#include "SsrResolveCS.h"
+#include "GpuTimer.h"
+
+// Matches the counters block in ssr_trace.comp
+struct SsrCounters {
+	GLuint pixels = 0;  // water pixels traced (half resolution)
+	GLuint steps = 0;   // Hi-Z steps over all of them
+};
+
+// Half-resolution screen-space reflections for water.
+// The water surface is drawn into a half-res normal/depth target, traced against this frame's Hi-Z
+// pyramid, then resolved temporally (reprojected history) and bilaterally; water samples the result.
+struct WaterSSR {
+	static constexpr int COUNTER_LATENCY = 4;   // frames between a trace and reading its counters
+
+	GLuint surfaceFbo = 0;
+	GLuint surface = 0;     // RGBA16F: view-space normal, view z (0 = no water)
+	GLuint trace = 0;       // RGBA16F: reflected color, confidence
+	GLuint history[2] = {}; // resolved result, ping-pong
+	int current = 0;        // history the last resolve wrote
+	int width = 0, height = 0;
+	int screenW = 0, screenH = 0;
+
+	mat4 prevViewProj;
+	bool historyValid = false;
+	float feedback = 0.85f;
+
+	SsrTraceCS* traceCS = nullptr;
+	SsrResolveCS* resolveCS = nullptr;
+	GpuTimer timer;
+
+	GLuint counterSSBO = 0;
+	GLuint counterReadback[COUNTER_LATENCY] = {};
+	SsrCounters counters;
+	int frame = 0;
+
+	void create(int w, int h) {
+		destroy();
+		screenW = w; screenH = h;
+
+		// Same size as Hi-Z level 0
+		width = max(1, (w + 1) / 2);
+		height = max(1, (h + 1) / 2);
+
+		surface = createTexture(GL_NEAREST);
+		trace = createTexture(GL_NEAREST);
+		history[0] = createTexture(GL_LINEAR);
+		history[1] = createTexture(GL_LINEAR);
+
+		glGenFramebuffers(1, &surfaceFbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, surfaceFbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, surface, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		const SsrCounters zero;
+		glGenBuffers(1, &counterSSBO);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(SsrCounters), &zero, GL_DYNAMIC_DRAW);
+		glGenBuffers(COUNTER_LATENCY, counterReadback);
+		for (int i = 0; i < COUNTER_LATENCY; i++) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, counterReadback[i]);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(SsrCounters), &zero, GL_DYNAMIC_READ);
+		}
+
+		traceCS = new SsrTraceCS();
+		resolveCS = new SsrResolveCS();
+		timer.init();
+		historyValid = false;
+	}
+
+	// drawSurface draws the water with the surface shader; leaves the surface framebuffer bound
+	// prevColor/prevDepth: last frame's scene, sceneDepth: this frame's opaque depth
+	void run(const RenderState& state, const std::function<void()>& drawSurface, GLuint prevColor, GLuint prevDepth, GLuint sceneDepth, const HiZBuffer& hiZ) {
+		timer.begin();
+		const mat4 viewProj = state.P * state.V;
+		const mat4 reproject = (historyValid ? prevViewProj : viewProj) * Inverse(state.V);
+
+		// Water surface, culled against the Hi-Z farthest depth in the fragment shader
+		glBindFramebuffer(GL_FRAMEBUFFER, surfaceFbo);
+		glViewport(0, 0, width, height);
+		const float clear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, clear);
+		GLboolean blendWasOn = glIsEnabled(GL_BLEND);
+		glDisable(GL_BLEND); // alpha carries the view depth
+		glDisable(GL_DEPTH_TEST);
+		glActiveTexture(GL_TEXTURE7);
+		glBindTexture(GL_TEXTURE_2D, hiZ.texture);
+		drawSurface();
+		glEnable(GL_DEPTH_TEST);
+		if (blendWasOn) glEnable(GL_BLEND);
+
+		// Trace
+		const GLuint zero = 0;
+		glClearNamedBufferData(counterSSBO, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		traceCS->Dispatch(surface, sceneDepth, prevColor, prevDepth, hiZ.texture, hiZ.levels, trace, counterSSBO,
+			width, height, screenW, screenH, state.P, state.invP, reproject, state.nearPlane, state.farPlane);
+
+		// Resolve into the other history
+		const int next = 1 - current;
+		resolveCS->Dispatch(surface, trace, history[current], history[next], width, height, state.invP, reproject, historyValid, feedback);
+		current = next;
+		timer.end();
+
+		// Counters of COUNTER_LATENCY frames ago
+		glCopyNamedBufferSubData(counterSSBO, counterReadback[frame % COUNTER_LATENCY], 0, 0, sizeof(SsrCounters));
+		frame++;
+		glGetNamedBufferSubData(counterReadback[frame % COUNTER_LATENCY], 0, sizeof(SsrCounters), &counters);
+
+		prevViewProj = viewProj;
+		historyValid = true;
+	}
+
+	GLuint result() const { return history[current]; }
+
+	// GPU time per traced water pixel, in nanoseconds
+	float getNsPerPixel() const { return counters.pixels ? timer.getMs() * 1e6f / float(counters.pixels) : 0.0f; }
+	float getStepsPerPixel() const { return counters.pixels ? float(counters.steps) / float(counters.pixels) : 0.0f; }
+
+	void destroy() {
+		GLuint textures[] = { surface, trace, history[0], history[1] };
+		glDeleteTextures(4, textures);
+		surface = trace = history[0] = history[1] = 0;
+		if (surfaceFbo) { glDeleteFramebuffers(1, &surfaceFbo); surfaceFbo = 0; }
+		if (counterSSBO) { glDeleteBuffers(1, &counterSSBO); counterSSBO = 0; }
+		glDeleteBuffers(COUNTER_LATENCY, counterReadback);
+		for (GLuint& b : counterReadback) b = 0;
+		if (traceCS) { delete traceCS; traceCS = nullptr; }
+		if (resolveCS) { delete resolveCS; resolveCS = nullptr; }
+		timer.destroy();
+	}
+
+private:
+	GLuint createTexture(GLint filter) {
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		return tex;
+	}
+};
@@ -6,5 +6,6 @@ struct WorldConfig {
     float chunkSize = 256.0f;
     unsigned int renderDist = 8;
     unsigned int tesselation = 32;
+    float impostorDist = 1024.0f; // chunk-center distance beyond which trees use impostors
     TerrainData terrain;
 };
@@ -2,6 +2,55 @@
 #include "framework.h"
 #include "globals.h"
 
+// Six planes by value, so per-frame culling never touches the heap
+using FrustumPlanes = std::array<vec4, 6>;
+
+// Gribb-Hartmann plane extraction, normalized, pointing inwards
+inline FrustumPlanes frustumPlanesFromVP(const mat4& viewProj) {
+    FrustumPlanes planes;
+    mat4 VP = TransposeMatrix(viewProj);
+
+    planes[0] = VP[3] + VP[0];          // Left 
+    planes[1] = VP[3] - VP[0];          // Right 
+    planes[2] = VP[3] + VP[1];          // Bottom 
+    planes[3] = VP[3] - VP[1];          // Top 
+    planes[4] = VP[3] + VP[2];          // Near 
+    planes[5] = VP[3] - VP[2];          // Far 
+
+    // Normalize
+    for (auto& p : planes) {
+        vec3 n = vec3(p.x, p.y, p.z);
+        float invLen = 1.0f / length(n);
+        p.x *= invLen; p.y *= invLen; p.z *= invLen; p.w *= invLen;
+    }
+
+    return planes;
+}
+
+// p-vertex test against inward planes
+inline bool aabbInFrustum(const AABB& box, const FrustumPlanes& planes) {
+    for (const vec4& p : planes) {
+        vec3 n = vec3(p.x, p.y, p.z);
+
+        // choose farthest corner in direction of the plane normal
+        vec3 pv = vec3(
+            n.x >= 0.0f ? box.max.x : box.min.x,
+            n.y >= 0.0f ? box.max.y : box.min.y,
+            n.z >= 0.0f ? box.max.z : box.min.z
+        );
+
+        if (dot(n, pv) + p.w < 0) return false; // outside
+    }
+    return true;
+}
+
+inline bool sphereInFrustum(const vec3& center, float radius, const FrustumPlanes& planes) {
+    for (const vec4& p : planes) {
+        if (dot(vec3(p.x, p.y, p.z), center) + p.w < -radius) return false;
+    }
+    return true;
+}
+
 class Camera {
 private:
 
@@ -31,26 +80,8 @@ public:
         farPlane = 2000.0f;
     }
 
-    std::vector<vec4> getFrustumPlanes() {
-        std::vector<vec4> planes(6);
-        mat4 VP = TransposeMatrix(P() * V());
-
-        planes[0] = VP[3] + VP[0];          // Left 
-        planes[1] = VP[3] - VP[0];          // Right 
-        planes[2] = VP[3] + VP[1];          // Bottom 
-        planes[3] = VP[3] - VP[1];          // Top 
-        planes[4] = VP[3] + VP[2];          // Near 
-        planes[5] = VP[3] - VP[2];          // Far 
-
-        // Normalize
-        for (auto& p : planes) {
-            vec3 n = vec3(p.x, p.y, p.z);
-            float invLen = 1.0f / length(n);
-            p.x *= invLen; p.y *= invLen; p.z *= invLen; p.w *= invLen;
-        }
-
-
-        return planes;
+    FrustumPlanes getFrustumPlanes() {
+        return frustumPlanesFromVP(P() * V());
     }
 
     void followPlayer(const vec3& playerPos, const vec3& playerDirection, float distanceBehind, float heightAbove, float followSpeed, float dt) {
@@ -10,9 +10,19 @@
 #include "SharedResources.h"
 #include "WorldConfig.h"
 
+// Matches the VertexBuffer header in marching_cubes.comp
+struct TerrainHeader {
+    GLuint vertexCount;
+    GLuint _pad[3];
+    GLuint boundsMin[4]; // order-preserving float bits
+    GLuint boundsMax[4];
+};
+
 class Chunk {
 protected:
     vec3 id;
+    int slot = -1;      // index into the culler's per-chunk buffers
+    AABB bounds;        // terrain plus anything vegetation can add on top
     
     WorldConfig* cfg = nullptr;
     SharedResources* resources = nullptr;
@@ -25,12 +35,11 @@ protected:
     GrassField* grassField = nullptr;
     GLuint segIndexSSBO = 0;     // binding = 5
     GLuint segIndexCount = 0;    // small number per chunk
-    std::unique_ptr<InstanceField> treeTrunkField;
-    std::unique_ptr<InstanceField> treeCrownField;
+    std::unique_ptr<InstanceField> treeField;
 
 public:
-    Chunk(vec3 id, WorldConfig* cfg, SharedResources* resources, TrackManager* trackManager)
-        : id(id), cfg(cfg), resources(resources) {
+    Chunk(vec3 id, int slot, WorldConfig* cfg, SharedResources* resources, TrackManager* trackManager)
+        : id(id), slot(slot), cfg(cfg), resources(resources) {
 
         // Build per-chunk list of road segments
         std::vector<int> indices;
@@ -45,7 +54,7 @@ public:
         grassField = new GrassField(24000, id, cfg->chunkSize, segIndexCount);
 
         maxVertices = cfg->tesselation * cfg->tesselation * cfg->tesselation * 15;
-        const GLsizeiptr headerSize = 16;
+        const GLsizeiptr headerSize = sizeof(TerrainHeader);
         const GLsizeiptr bufferSize = headerSize + sizeof(vec4) * maxVertices;
 
         // VBO
@@ -53,9 +62,10 @@ public:
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, vbo);
         glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
         
-        // Zero header (vertexCount)
-        GLuint zero = 0;
-        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+        // Zero vertexCount, empty bounds
+        TerrainHeader header = {};
+        for (int i = 0; i < 4; i++) header.boundsMin[i] = 0xFFFFFFFFu;
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(TerrainHeader), &header);
 
         // Bind to binding = 0
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vbo);
@@ -63,14 +73,37 @@ public:
         // Dispatch
         resources->marchingCubesCS->Dispatch(cfg->tesselation / 8, cfg->tesselation / 8, cfg->tesselation / 8, id, cfg->chunkSize, cfg->tesselation, segIndexCount);
         
-        // Retrieve actual vertex count
-        glGetNamedBufferSubData(vbo, 0, sizeof(GLuint), &actualVertexCount);
-
-        treeTrunkField = std::make_unique<InstanceField>(id, cfg->chunkSize, resources->treeTrunkGeoms, resources->treeTrunkShader, resources->terrainHeightCS, segIndexSSBO, segIndexCount);
-        treeCrownField = std::make_unique<InstanceField>(id, cfg->chunkSize, resources->treeCrownGeoms, resources->treeLeafShader, resources->terrainHeightCS, segIndexSSBO, segIndexCount);
+        // Retrieve actual vertex count and tight bounds; an empty chunk keeps its whole cube
+        glGetNamedBufferSubData(vbo, 0, sizeof(TerrainHeader), &header);
+        actualVertexCount = header.vertexCount;
+        AABB terrainBounds;
+        terrainBounds.min = id * cfg->chunkSize;
+        terrainBounds.max = terrainBounds.min + vec3(cfg->chunkSize, cfg->chunkSize, cfg->chunkSize);
+        if (actualVertexCount > 0) {
+            terrainBounds.min = vec3(orderedBitsToFloat(header.boundsMin[0]), orderedBitsToFloat(header.boundsMin[1]), orderedBitsToFloat(header.boundsMin[2]));
+            terrainBounds.max = vec3(orderedBitsToFloat(header.boundsMax[0]), orderedBitsToFloat(header.boundsMax[1]), orderedBitsToFloat(header.boundsMax[2]));
+        }
+
+        // Trees: one GPU scatter shared by trunks and crowns
+        treeField = std::make_unique<InstanceField>(id, cfg->chunkSize, (int)resources->treeTrunkGeoms.size(), resources->treeScatterCS, segIndexSSBO, segIndexCount);
+        treeField->AddBatch(resources->treeTrunkGeoms, resources->treeTrunkShader);
+        treeField->AddBatch(resources->treeCrownGeoms, resources->treeLeafShader);
+        if (resources->treeImpostors) treeField->SetImpostors(resources->treeImpostors, resources->treeImpostorShader);
+
+        // Grass blades and trees reach past the terrain surface
+        float reach = resources->culler ? resources->culler->getVegetationReach() : 0.0f;
+        bounds.min = terrainBounds.min - vec3(reach, 0.0f, reach);
+        bounds.max = terrainBounds.max + vec3(reach, reach, reach);
+
+        if (resources->culler) {
+            resources->culler->RegisterChunk(slot, id * cfg->chunkSize, cfg->chunkSize, terrainBounds, actualVertexCount, grassField);
+            grassField->SetCulledCommands(resources->culler->getCommandBuffer(), resources->culler->GrassCommandOffset(slot));
+            treeField->SetCulling(resources->culler, slot);
+        }
     }
 
     ~Chunk() {
+        if (resources->culler) resources->culler->UnregisterChunk(slot);
         if (vbo) glDeleteBuffers(1, &vbo);
         if (segIndexSSBO) glDeleteBuffers(1, &segIndexSSBO);
         if (grassField) { grassField->destroy(); delete grassField; grassField = nullptr; }
@@ -83,14 +116,30 @@ public:
         resources->terrainShader->Bind(state);
 
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vbo);
-        glDrawArrays(GL_TRIANGLES, 0, actualVertexCount);
+        if (resources->culler && !state.shadowPass) {
+            // Single instance when the cull pass found the terrain visible, none otherwise
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, resources->culler->getCommandBuffer());
+            glDrawArraysIndirect(GL_TRIANGLES, (void*)resources->culler->SlotOffset(slot));
+        }
+        else glDrawArrays(GL_TRIANGLES, 0, actualVertexCount);
 
         if(grassField) grassField->Draw(state);
-        if (treeTrunkField)  treeTrunkField->Draw(state);
-        if (treeCrownField)  treeCrownField->Draw(state);
+        if (treeField) {
+            // Distant chunks draw one quad per tree
+            vec2 d = vec2((id.x + 0.5f) * cfg->chunkSize - state.cameraPos.x, (id.z + 0.5f) * cfg->chunkSize - state.cameraPos.z);
+
+            // LODs use the nearest point of the chunk so no tree in it is under-detailed
+            float half = 0.5f * cfg->chunkSize;
+            float nearest = length(vec2(max(fabsf(d.x) - half, 0.0f), max(fabsf(d.y) - half, 0.0f)));
+
+            if (length(d) > cfg->impostorDist) treeField->DrawImpostors(state, nearest);
+            else treeField->Draw(state, nearest);
+        }
     }
 
     // Getters
+    int getSlot() const { return slot; }
+    const AABB& getBounds() const { return bounds; }
     GLuint getSegIndexSSBO()  const { return segIndexSSBO; }
     GLuint getSegIndexCount() const { return segIndexCount; }
 
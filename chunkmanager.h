@@ -1,26 +1,44 @@
 #pragma once
 #include "framework.h"
 #include "chunk.h"
-#include <unordered_map>
 #include "camera.h"
 #include "object.h"
 #include "TrackManager.h"
 #include "SharedResources.h"
 #include "WorldConfig.h"
+#include "ChunkVisibility.h"
+
+// One grid cell; x, z tell which chunk currently lives in it
+struct GridSlot {
+    int x = 0, z = 0;
+    std::unique_ptr<Chunk> chunk;
+};
 
 class ChunkManager {
 private:
-    std::unordered_map<vec3, std::unique_ptr<Chunk>, Vec3Hash, Vec3Equal> chunkMap;
+    // Toroidal grid of (2 * renderDist + 1)^2 slots: chunk (x, z) lives in slot (z mod side) * side + (x mod side).
+    // Every chunk in render distance has its own slot, and the chunk that scrolls out is replaced in place.
+    // The slot index is also the chunk's culler slot.
+    std::vector<GridSlot> grid;
+    int side = 0;
+    int centerX = 0, centerZ = 0;   // chunk under the camera
+    bool hasCenter = false;
+
     std::vector<vec3> loadQueue;
+    std::vector<AABB> changedBounds; // chunks loaded or unloaded since the last TakeChangedBounds()
+
+    // CPU culling over the grid around the center; handles are slots
+    ChunkVisibility visibility;
+    std::vector<int> visibleSlots;   // reused every query
     const int maxKicksPerFrame = 1;
 
     SharedResources* resources = nullptr;
 
     Object* waterObject = nullptr;
+    Object* waterSurfaceObject = nullptr;   // same plane, SSR surface pass
 
     WorldConfig* cfg;
     GLuint vao = 0;         // Shared VAO for all chunks
-    GLuint terrainUBO = 0;  // Terrain UBO that any shader can access
     TrackManager* trackManager = nullptr;
 
 public:
@@ -30,38 +48,60 @@ public:
         glBindVertexArray(vao);
         glBindVertexArray(0);
 
-        // UBO for terrain params (binding = 3)
-        glGenBuffers(1, &terrainUBO);
-        glBindBuffer(GL_UNIFORM_BUFFER, terrainUBO);
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(TerrainData), nullptr, GL_DYNAMIC_DRAW);
-        glBindBufferRange(GL_UNIFORM_BUFFER, 3, terrainUBO, 0, sizeof(TerrainData));
-
+        // Terrain params that any shader can access (binding = 3)
         updateTerrainUBO();
 
+        // One slot per chunk in render distance
+        side = 2 * cfg->renderDist + 1;
+        grid.resize(side * side);
+        visibility.resize(cfg->renderDist);
+
         trackManager = new TrackManager(cfg->terrain.seed);
         waterObject = new Object(resources->waterShader, resources->waterGeom);
+        waterSurfaceObject = new Object(resources->waterSurfaceShader, resources->waterGeom);
     }
 
 
     ~ChunkManager() {
         if (vao) glDeleteVertexArrays(1, &vao);
-        if (terrainUBO) glDeleteBuffers(1, &terrainUBO);
         delete trackManager;
         delete waterObject;
+        delete waterSurfaceObject;
     }
 
     void EnqueueChunk(const vec3& id) {
-        if (chunkMap.find(id) != chunkMap.end()) return; // already loaded
+        if (findChunk((int)id.x, (int)id.z)) return; // already loaded
         loadQueue.push_back(id);
     }
 
     void LoadChunk(const vec3& id) {
-        if (chunkMap.find(id) != chunkMap.end()) return; // already loaded
-        chunkMap.emplace(id, std::make_unique<Chunk>(id, cfg, resources, trackManager));
+        int x = (int)id.x, z = (int)id.z;
+        if (!inRange(x, z)) return; // stale request, its slot belongs to a chunk in range now
+
+        int slot = slotIndex(x, z);
+        GridSlot& cell = grid[slot];
+        if (cell.chunk) {
+            if (cell.x == x && cell.z == z) return; // already loaded
+            unloadSlot(slot);
+        }
+
+        cell.x = x;
+        cell.z = z;
+        cell.chunk = std::make_unique<Chunk>(id, slot, cfg, resources, trackManager);
+        visibility.insert(gridX(x), gridZ(z), cell.chunk->getBounds(), slot);
+        changedBounds.push_back(cell.chunk->getBounds());
     }
 
     void UnloadChunk(const vec3& id) {
-        chunkMap.erase(id);
+        int x = (int)id.x, z = (int)id.z;
+        if (findChunk(x, z)) unloadSlot(slotIndex(x, z));
+    }
+
+    // Lets cached passes (e.g. shadow cascades) invalidate only where the world changed
+    std::vector<AABB> TakeChangedBounds() {
+        std::vector<AABB> out;
+        out.swap(changedBounds);
+        return out;
     }
 
     void KickChunkLoading() {
@@ -75,62 +115,67 @@ public:
     }
 
     void Update(const vec3& cameraPos) {
-        static vec3 lastChunkId = vec3(9999);
-        vec3 currentChunk = vec3(floor(cameraPos.x / cfg->chunkSize), 0.0f, floor(cameraPos.z / cfg->chunkSize));
+        // Terrain params live in per-frame ring memory
+        updateTerrainUBO();
 
-        if (currentChunk != lastChunkId) {
-            for (int x = -static_cast<int>(cfg->renderDist); x <= static_cast<int>(cfg->renderDist); ++x) {
-                for (int z = -static_cast<int>(cfg->renderDist); z <= static_cast<int>(cfg->renderDist); ++z) {
-                    EnqueueChunk(vec3(currentChunk.x + x, 0, currentChunk.z + z));
-                }
+        int x = (int)floor(cameraPos.x / cfg->chunkSize);
+        int z = (int)floor(cameraPos.z / cfg->chunkSize);
+
+        if (!hasCenter || x != centerX || z != centerZ) {
+            centerX = x;
+            centerZ = z;
+            hasCenter = true;
+
+            // Free the slots that scrolled out; the chunks replacing them map to the same slots
+            for (int slot = 0; slot < (int)grid.size(); slot++) {
+                if (grid[slot].chunk && !inRange(grid[slot].x, grid[slot].z)) unloadSlot(slot);
             }
 
-            std::vector<vec3> chunksToUnload;
-            for (const auto& pair : chunkMap) {
-                vec3 id = pair.first;
-                if (abs(id.x - currentChunk.x) > static_cast<float>(cfg->renderDist) || abs(id.z - currentChunk.z) > static_cast<float>(cfg->renderDist)) {
-                    chunksToUnload.push_back(id);
+            const int r = (int)cfg->renderDist;
+            loadQueue.clear();
+            for (int dx = -r; dx <= r; ++dx) {
+                for (int dz = -r; dz <= r; ++dz) {
+                    EnqueueChunk(vec3(float(centerX + dx), 0.0f, float(centerZ + dz)));
                 }
             }
 
-            for (const vec3& id : chunksToUnload) {
-                UnloadChunk(id);
+            // Re-anchor the culling grid on the new center
+            visibility.clear();
+            for (int slot = 0; slot < (int)grid.size(); slot++) {
+                const GridSlot& cell = grid[slot];
+                if (cell.chunk) visibility.insert(gridX(cell.x), gridZ(cell.z), cell.chunk->getBounds(), slot);
             }
-
-            lastChunkId = currentChunk;
         }
 
         KickChunkLoading();
     }
 
-    bool isChunkVisible(const vec3& chunkPos, float chunkSize, const std::vector<vec4>& frustumPlanes, const vec3& cameraPos) {
-        // Build AABB
-        AABB box;
-        box.min = chunkPos;
-        box.max = chunkPos + vec3(chunkSize, chunkSize, chunkSize);
-
-        // If the camera is inside the box, always draw
-        if (pointInAABB(cameraPos, box)) return true;
-
-        // p-vertex test
-        for (const vec4& p : frustumPlanes) {
-            vec3 n = vec3(p.x, p.y, p.z);
+    // ---------- Grid ----------
+    int slotIndex(int x, int z) const {
+        int wx = x % side, wz = z % side;
+        if (wx < 0) wx += side;
+        if (wz < 0) wz += side;
+        return wz * side + wx;
+    }
 
-            // choose farthest corner in direction of the plane normal
-            vec3 pv = vec3(
-                n.x >= 0.0f ? box.max.x : box.min.x,
-                n.y >= 0.0f ? box.max.y : box.min.y,
-                n.z >= 0.0f ? box.max.z : box.min.z
-            );
+    bool inRange(int x, int z) const {
+        return hasCenter && abs(x - centerX) <= (int)cfg->renderDist && abs(z - centerZ) <= (int)cfg->renderDist;
+    }
 
-            float dist = dot(n, pv) + p.w;
-            if (dist < 0) return false; // outside
-        }
-        return true; // intersects or fully inside
+    Chunk* findChunk(int x, int z) const {
+        const GridSlot& cell = grid[slotIndex(x, z)];
+        return (cell.chunk && cell.x == x && cell.z == z) ? cell.chunk.get() : nullptr;
     }
 
-    bool isChunkNeighbor(const vec3& currentChunkId, const vec3& chunkId) {
-        return abs(currentChunkId.x - chunkId.x) <= 2.0f && abs(currentChunkId.z - chunkId.z) <= 2.0f;
+    // Coordinates relative to the culling grid corner
+    int gridX(int x) const { return x - centerX + (int)cfg->renderDist; }
+    int gridZ(int z) const { return z - centerZ + (int)cfg->renderDist; }
+
+    void unloadSlot(int slot) {
+        GridSlot& cell = grid[slot];
+        visibility.remove(gridX(cell.x), gridZ(cell.z));
+        changedBounds.push_back(cell.chunk->getBounds()); // vegetation reach included
+        cell.chunk.reset();
     }
 
 
@@ -139,8 +184,8 @@ public:
         std::vector<vec3> chunkIds;
 
         // Store the IDs of all currently loaded chunks
-        for (const auto& pair : chunkMap) {
-            chunkIds.push_back(pair.first);
+        for (const GridSlot& cell : grid) {
+            if (cell.chunk) chunkIds.push_back(vec3(float(cell.x), 0.0f, float(cell.z)));
         }
 
         // Unload all chunks
@@ -156,23 +201,30 @@ public:
 
 
     void DrawChunks(RenderState& state, Camera& camera) {
+        // Tight bounds include everything the chunk draws, so no neighborhood has to be forced in;
+        // what survives here is culled further on the GPU
+        DrawChunks(state, camera.getFrustumPlanes());
+    }
+
+    // Any frustum (camera or light): quadtree over the chunk grid, SIMD tests at the leaves
+    void DrawChunks(RenderState& state, const FrustumPlanes& frustumPlanes) {
         glBindVertexArray(vao);
-        
-        vec3 cameraPos = camera.getPos();
-        vec3 currentChunk = vec3(floor(cameraPos.x / cfg->chunkSize), 0.0f, floor(cameraPos.z / cfg->chunkSize));
-        std::vector<vec4> frustumPlanes = camera.getFrustumPlanes();
-        for (auto& pair : chunkMap) {
-            vec3 chunkPos = pair.first * cfg->chunkSize;
-            if (isChunkVisible(chunkPos, cfg->chunkSize, frustumPlanes, cameraPos) || isChunkNeighbor(currentChunk, pair.first)) {
-                pair.second->Draw(state);
-            }
-        }
+
+        visibleSlots.clear();
+        visibility.query(frustumPlanes, visibleSlots);
+        for (int slot : visibleSlots) grid[slot].chunk->Draw(state);
     }
 
+    const ChunkVisibility& getVisibility() const { return visibility; }
+
     void DrawWater(RenderState& state) {
         if (waterObject) waterObject->Draw(state);
     }
 
+    void DrawWaterSurface(RenderState& state) {
+        if (waterSurfaceObject) waterSurfaceObject->Draw(state);
+    }
+
     void updateTerrainUBO() {
         // order must match the GLSL block
         struct Params {
@@ -211,8 +263,7 @@ public:
             cfg->terrain.waterLevel
         };
 
-        glBindBuffer(GL_UNIFORM_BUFFER, terrainUBO);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(p), &p);
+        resources->stream->bind(GL_UNIFORM_BUFFER, 3, &p, sizeof(p));
     }
 
     vec3 getSpawnPoint() {
@@ -223,11 +274,10 @@ public:
     }
 
     bool getSegIndexForPos(const vec3& worldPos, GLuint& outSSBO, GLuint& outCount) const {
-        vec3 id = vec3(floor(worldPos.x / cfg->chunkSize), 0.0f, floor(worldPos.z / cfg->chunkSize));
-        auto it = chunkMap.find(id);
-        if (it == chunkMap.end()) { outSSBO = 0; outCount = 0; return false; }
-        outSSBO = it->second->getSegIndexSSBO();
-        outCount = it->second->getSegIndexCount();
+        const Chunk* chunk = findChunk((int)floor(worldPos.x / cfg->chunkSize), (int)floor(worldPos.z / cfg->chunkSize));
+        if (!chunk) { outSSBO = 0; outCount = 0; return false; }
+        outSSBO = chunk->getSegIndexSSBO();
+        outCount = chunk->getSegIndexCount();
         return true;
     }
 
@@ -0,0 +1,78 @@
+#pragma once
+#include "geometry.h"
+
+// Nested grid rings for a camera-centred surface (geometry clipmap), one indexed mesh for all levels.
+// Level L has cells of cellSize * 2^L and spans [-ringCells, ringCells) cells around its own origin, which
+// the vertex shader snaps to 2 cells of that level. Levels above 0 leave a hole for the level below. The
+// cells on the hole's border are trim: depending on how the finer level snapped, one row and one column
+// of them is covered by it, so the shader collapses the covered ones.
+//
+// Vertices are (x, code, z) with x, z in cells of their level and code = level + 16 * trim category,
+// trim category = cx + 3 * cz (0 = always drawn). Per axis: 0 inside the hole, 1 on its low border
+// (covered when the finer level did not move up a cell), 2 on its high border (covered when it did).
+class ClipmapGeometry : public Geometry {
+    int ringCells;
+    int levels;
+
+public:
+    ClipmapGeometry(int ringCells, int levels) : ringCells(ringCells), levels(levels) {
+        std::vector<vec3> vtxData;
+        std::vector<uint32_t> idxData;
+        const int n = ringCells;
+        const int h = n / 2;
+
+        for (int level = 0; level < levels; level++) {
+            // Shared vertex grid of the level; cells inside the hole are simply not indexed
+            const uint32_t base = (uint32_t)vtxData.size();
+            const int side = 2 * n + 1;
+            for (int z = -n; z <= n; z++)
+                for (int x = -n; x <= n; x++)
+                    vtxData.push_back(vec3(float(x), float(level), float(z)));
+
+            auto gridIndex = [&](int x, int z) { return base + uint32_t((z + n) * side + (x + n)); };
+
+            for (int j = -n; j < n; j++) {
+                for (int i = -n; i < n; i++) {
+                    bool inHole = level > 0 && i >= -h && i <= h && j >= -h && j <= h;
+                    if (inHole) continue;
+                    pushQuad(idxData, gridIndex(i, j), gridIndex(i + 1, j), gridIndex(i + 1, j + 1), gridIndex(i, j + 1));
+                }
+            }
+
+            // Trim: the hole's border cells with their own vertices, so each cell can collapse on its own
+            if (level == 0) continue;
+            for (int j = -h; j <= h; j++) {
+                for (int i = -h; i <= h; i++) {
+                    int cx = i == -h ? 1 : (i == h ? 2 : 0);
+                    int cz = j == -h ? 1 : (j == h ? 2 : 0);
+                    if (cx == 0 && cz == 0) continue; // always covered by the finer level
+
+                    float code = float(level + 16 * (cx + 3 * cz));
+                    uint32_t first = (uint32_t)vtxData.size();
+                    vtxData.push_back(vec3(float(i), code, float(j)));
+                    vtxData.push_back(vec3(float(i + 1), code, float(j)));
+                    vtxData.push_back(vec3(float(i + 1), code, float(j + 1)));
+                    vtxData.push_back(vec3(float(i), code, float(j + 1)));
+                    pushQuad(idxData, first, first + 1, first + 2, first + 3);
+                }
+            }
+        }
+
+        init(vtxData, idxData); // upload to GPU
+    }
+
+    int getRingCells() const { return ringCells; }
+    int getLevels() const { return levels; }
+
+private:
+    // Corners (x0,z0), (x1,z0), (x1,z1), (x0,z1); same winding as PlaneGeometry
+    static void pushQuad(std::vector<uint32_t>& idxData, uint32_t p00, uint32_t p10, uint32_t p11, uint32_t p01) {
+        idxData.push_back(p11);
+        idxData.push_back(p10);
+        idxData.push_back(p00);
+
+        idxData.push_back(p01);
+        idxData.push_back(p11);
+        idxData.push_back(p00);
+    }
+};
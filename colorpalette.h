@@ -1,6 +1,7 @@
 #pragma once
 #include "framework.h"
 #include <imgui.h>
+#include "StreamBuffer.h"
 
 struct ColorPaletteUBO {
     vec4 terrainColors[5];
@@ -16,12 +17,6 @@ struct ColorPaletteUBO {
 class ColorPalette {
 private:
     ColorPaletteUBO palette{};
-    GLuint colorUBO = 0; // binding = 7
-
-    void updatePaletteUBO() {
-        glBindBuffer(GL_UNIFORM_BUFFER, colorUBO);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ColorPaletteUBO), &palette);
-    }
 
     // Enforce monotonic thresholds (t1 <= t2 <= t3 <= t4)
     static void sortThresholds(vec4& t) {
@@ -32,12 +27,12 @@ private:
 
 public:
     ColorPalette() {
-        glGenBuffers(1, &colorUBO);
-        glBindBuffer(GL_UNIFORM_BUFFER, colorUBO);
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(ColorPaletteUBO), nullptr, GL_STATIC_DRAW);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 7, colorUBO);
         SetDefaults(); // fill palette
-        updatePaletteUBO();
+    }
+
+    // Every frame: ring memory does not outlive it
+    void updatePaletteUBO(StreamBuffer& stream) const {
+        stream.bind(GL_UNIFORM_BUFFER, 7, &palette, sizeof(ColorPaletteUBO)); // binding = 7
     }
 
     // Defaults
@@ -230,7 +225,6 @@ public:
             }
         }
 
-        if (changed) updatePaletteUBO();
         return changed;
     }
 };
@@ -0,0 +1,4 @@
+#version 450 core
+
+// Shared by the depth-only variants of opaque shaders: the rasterizer writes depth, nothing is shaded
+void main() {}
@@ -8,6 +8,7 @@
 #include <math.h>
 #include <vector>
 #include <string>
+#include <cstring>
 #include <windows.h>
 #include <chrono>
 #include <GL/glew.h>
@@ -414,6 +415,14 @@ inline bool pointInAABB(const vec3& p, const AABB& b) {
 		(p.z >= b.min.z && p.z <= b.max.z);
 }
 
+// Inverse of the order-preserving float encoding the compute shaders use with atomicMin/atomicMax
+inline float orderedBitsToFloat(uint32_t u) {
+	uint32_t bits = (u & 0x80000000u) ? (u & 0x7FFFFFFFu) : ~u;
+	float f;
+	memcpy(&f, &bits, sizeof(float));
+	return f;
+}
+
 uint32_t hash3(const vec3& v) {
 	int32_t xi = (int32_t)std::floor(v.x);
 	int32_t yi = (int32_t)std::floor(v.y);
@@ -428,4 +437,34 @@ uint32_t hash3(const vec3& v) {
 	h ^= h >> 15; h *= 0x846CA68Bu;
 	h ^= h >> 16;
 	return h;
-}
\ No newline at end of file
+}
+
+// Float to IEEE 754 half, round to nearest (CPU side of GLSL unpackHalf2x16)
+inline uint16_t floatToHalf(float f) {
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+
+	uint32_t sign = (x >> 16) & 0x8000u;
+	int32_t  exp = int32_t((x >> 23) & 0xFF) - 127 + 15;
+	uint32_t mant = x & 0x7FFFFFu;
+
+	if (((x >> 23) & 0xFF) == 0xFF) return uint16_t(sign | 0x7C00u | (mant ? 0x200u : 0u)); // inf/nan
+	if (exp >= 31) return uint16_t(sign | 0x7C00u); // overflow
+	if (exp <= 0) {
+		// Subnormal or zero
+		if (exp < -10) return uint16_t(sign);
+		mant |= 0x800000u;
+		uint32_t shift = uint32_t(14 - exp);
+		uint32_t half = mant >> shift;
+		if ((mant >> (shift - 1)) & 1u) half++;
+		return uint16_t(sign | half);
+	}
+
+	uint32_t half = sign | (uint32_t(exp) << 10) | (mant >> 13);
+	if (mant & 0x1000u) half++; // carry into the exponent is still correct
+	return uint16_t(half);
+}
+
+inline uint32_t packHalf2x16(float lo, float hi) {
+	return uint32_t(floatToHalf(lo)) | (uint32_t(floatToHalf(hi)) << 16);
+}
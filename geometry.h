@@ -1,17 +1,39 @@
 #pragma once
 #include "framework.h"
 
+// CPU-side triangle mesh with shared vertices
+struct IndexedMesh {
+	std::vector<vec3> vtx;
+	std::vector<uint32_t> idx;
+
+	size_t triangleCount() const { return idx.size() / 3; }
+};
+
+// One drawable sub-range: first vertex for un-indexed geometry, first index otherwise
+struct DrawRange {
+	GLuint count;
+	GLuint first;
+	GLint  baseVertex;
+};
+
 class Geometry {
 protected:
-	unsigned int vao = 0, vbo = 0;
+	unsigned int vao = 0, vbo = 0, ebo = 0;
 	int vertexCount = 0;
+	int indexCount = 0; // 0 for un-indexed geometry
+	AABB bounds;
+	std::vector<DrawRange> lods; // lods[0] is the full mesh
 
-public:
-	Geometry() {}
-
-	void init(const std::vector<vec3> vtxData) {
+	void upload(const std::vector<vec3>& vtxData) {
 		vertexCount = vtxData.size();
 
+		// Object-space bounds
+		bounds.min = bounds.max = vtxData.empty() ? vec3(0.0f) : vtxData[0];
+		for (const vec3& v : vtxData) {
+			bounds.min = minVec3(bounds.min, v);
+			bounds.max = maxVec3(bounds.max, v);
+		}
+
 		glGenVertexArrays(1, &vao);
 		glGenBuffers(1, &vbo);
 
@@ -22,12 +44,70 @@ public:
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
 	}
 
-	void Draw() {
+	void uploadIndices(const std::vector<uint32_t>& idxData) {
+		glGenBuffers(1, &ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo); // recorded in vao
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxData.size() * sizeof(uint32_t), idxData.data(), GL_STATIC_DRAW);
+		glBindVertexArray(0);
+	}
+
+public:
+	Geometry() {}
+
+	void init(const std::vector<vec3>& vtxData) {
+		upload(vtxData);
+		lods = { { (GLuint)vertexCount, 0u, 0 } };
+	}
+
+	// Shared vertices with a triangle index list
+	void init(const std::vector<vec3>& vtxData, const std::vector<uint32_t>& idxData) {
+		upload(vtxData);
+		uploadIndices(idxData);
+		indexCount = idxData.size();
+		lods = { { (GLuint)indexCount, 0u, 0 } };
+	}
+
+	// Discrete LODs packed into one vertex and one index buffer
+	void init(const std::vector<IndexedMesh>& lodMeshes) {
+		std::vector<vec3> vtxData;
+		std::vector<uint32_t> idxData;
+		lods.clear();
+		for (const IndexedMesh& m : lodMeshes) {
+			lods.push_back({ (GLuint)m.idx.size(), (GLuint)idxData.size(), (GLint)vtxData.size() });
+			vtxData.insert(vtxData.end(), m.vtx.begin(), m.vtx.end());
+			idxData.insert(idxData.end(), m.idx.begin(), m.idx.end());
+		}
+
+		upload(vtxData);
+		uploadIndices(idxData);
+		indexCount = lods.empty() ? 0 : lods[0].count;
+	}
+
+	// Screen-size LOD choice for a bounding sphere scaled by `scale` at `distance` from the camera
+	int selectLod(float distance, const mat4& P, float scale = 1.0f) const {
+		if (lods.size() <= 1) return 0;
+
+		// Projected bounding radius (fraction of half the viewport height) below which LOD i+1 is used
+		static const float lodScreenSize[] = { 0.25f, 0.12f, 0.05f };
+
+		float radius = length(bounds.max - bounds.min) * 0.5f * scale;
+		bool ortho = P[3].w != 0.0f; // e.g. the shadow pass
+		float size = ortho ? radius * P[1].y : radius * P[1].y / max(distance, 0.001f);
+
+		int lod = 0;
+		while (lod + 1 < (int)lods.size() && lod < 3 && size < lodScreenSize[lod]) lod++;
+		return lod;
+	}
+
+	void Draw(int lod = 0) {
+		const DrawRange& r = lods[min(lod, (int)lods.size() - 1)];
 		glBindVertexArray(vao);
-		glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+		if (indexCount > 0) glDrawElementsBaseVertex(GL_TRIANGLES, r.count, GL_UNSIGNED_INT, (void*)(r.first * sizeof(uint32_t)), r.baseVertex);
+		else glDrawArrays(GL_TRIANGLES, r.first, r.count);
 	}
 
 	virtual ~Geometry() {
+		if (ebo) glDeleteBuffers(1, &ebo);
 		glDeleteBuffers(1, &vbo);
 		glDeleteVertexArrays(1, &vao);
 	}
@@ -35,5 +115,12 @@ public:
 	// Getters
 	GLuint getVAO() const { return vao; }
 	GLuint getVBO()  const { return vbo; }
+	GLuint getEBO()  const { return ebo; }
 	GLsizei getVertexCount() const { return vertexCount; }
+	GLsizei getIndexCount() const { return indexCount; }
+	bool isIndexed() const { return indexCount > 0; }
+	const AABB& getBounds() const { return bounds; }
+	const std::vector<DrawRange>& getLods() const { return lods; }
+	int getLodCount() const { return (int)lods.size(); }
+	GLsizei getTriangleCount(int lod = 0) const { return lods[lod].count / 3; }
 };
@@ -30,40 +30,50 @@ layout(std140, binding = 7) uniform ColorPalette {
     float u_fogDensity;
 };
 
-layout(binding = 2) uniform sampler2D u_shadowMap;
+#define SHADOW_CASCADES 4
+layout(binding = 2) uniform sampler2DArray u_shadowMap;
+uniform mat4 u_cascadeVP[SHADOW_CASCADES];
+uniform vec4 u_cascadeSplits;
 uniform float u_shadowBias;
 uniform vec2 u_shadowTexel;
 
 in float colorOffset;
 in float viewDist_WS;
 in vec3 viewDir_WS;
-in vec4 lightPos_CS;
+in vec3 vtxPos_WS;
 
 out vec4 fragmentColor;
 
 // ---------- Shadow ----------
-float shadowMask(vec4 lightPos_CS) {
-    // Clip to NDC
-    vec3 proj = lightPos_CS.xyz / lightPos_CS.w;
-    vec2 uv = proj.xy * 0.5 + 0.5;
-    float depth = proj.z * 0.5 + 0.5;
-
-    // Outside map
-    if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) return 1.0;
-
-    // 3x3 PCF
-    float vis = 0.0;
-    int kernel = 1;
-    for (int dx = -kernel; dx <= kernel; ++dx) {
-        for (int dy = -kernel; dy <= kernel; ++dy) {
-            vec2 offset = vec2(dx, dy) * u_shadowTexel;
-            float closest = texture(u_shadowMap, uv + offset).r;
-            float current = depth - u_shadowBias;
-            vis += (current <= closest) ? 1.0 : 0.0;
+float shadowMask(vec3 pos_WS, float viewDist) {
+    // First cascade whose range covers the fragment; a cascade still waiting for its refresh falls through to the next
+    for (int c = 0; c < SHADOW_CASCADES; c++) {
+        if (viewDist > u_cascadeSplits[c]) continue;
+
+        // World to light NDC
+        vec4 lightClip = u_cascadeVP[c] * vec4(pos_WS, 1.0);
+        vec3 proj = lightClip.xyz / lightClip.w;
+        vec2 uv = proj.xy * 0.5 + 0.5;
+        float depth = proj.z * 0.5 + 0.5;
+
+        // Outside map
+        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) continue;
+
+        // 3x3 PCF
+        float vis = 0.0;
+        int kernel = 1;
+        for (int dx = -kernel; dx <= kernel; ++dx) {
+            for (int dy = -kernel; dy <= kernel; ++dy) {
+                vec2 offset = vec2(dx, dy) * u_shadowTexel;
+                float closest = texture(u_shadowMap, vec3(uv + offset, float(c))).r;
+                float current = depth - u_shadowBias;
+                vis += (current <= closest) ? 1.0 : 0.0;
+            }
         }
-    }
 
-    return vis / pow(kernel * 2 + 1, 2);
+        return vis / pow(kernel * 2 + 1, 2);
+    }
+    return 1.0;
 }
 
 // ---------- Main ----------
@@ -86,7 +96,7 @@ void main() {
 	vec3 diffuse = material.kd.xyz * texColor * diff * u_lightLe.xyz;
 	vec3 specular = material.ks.xyz * spec * u_lightLe.xyz;
 
-    float shadow = shadowMask(lightPos_CS);
+    float shadow = shadowMask(vtxPos_WS, viewDist_WS);
     vec3 radiance = ambient + (diffuse + specular) * shadow;
 
     // Base sky gradient
@@ -8,19 +8,20 @@ class GrassShader : public Shader {
 public:
 	GrassShader() {
 		create("grassshader.vert", "grassshader.frag", "fragmentColor");
+		createDepthOnly("grassshader.vert");
 	}
 
 	void Bind(RenderState state) {
-		Use();
+		Use(state.depthOnly);
 
 		setUniform(state.time, "u_time");
-		setUniform(state.cameraPos, "u_camPos_WS");
 		setUniform(state.V, "u_V");
 		setUniform(state.P, "u_P");
+		if (state.depthOnly) return;
+
+		setUniform(state.cameraPos, "u_camPos_WS");
 
 		// Shadow
-		setUniform(state.lightVP, "u_lightVP");
-		setUniform(state.shadowTexel, "u_shadowTexel");
-		setUniform(state.shadowBias, "u_shadowBias");
+		setShadowUniforms(state);
 	}
 };
@@ -12,12 +12,16 @@ layout (location=5) in float instPhase;
 uniform float u_time;
 uniform vec3 u_camPos_WS;
 uniform mat4 u_V, u_P;
-uniform mat4 u_lightVP;
 
+invariant gl_Position;
+#ifndef DEPTH_ONLY
 out float colorOffset;
 out float viewDist_WS;
 out vec3 viewDir_WS;
-out vec4 lightPos_CS;
+out vec3 vtxPos_WS;
+#else
+vec3 vtxPos_WS;
+#endif
 
 float u_windStrength = 1.0;
 vec2  u_windDir = vec2(1.0, 0.3); // XZ direction
@@ -43,11 +47,12 @@ void main() {
     // Rotate
     p.xz = rot(instYaw) * p.xz;
 
-    vec3 vtxPos_WS = instPos_WS + p;
+    vtxPos_WS = instPos_WS + p;
     gl_Position = u_P * u_V * vec4(vtxPos_WS, 1.0);
 
+#ifndef DEPTH_ONLY
     viewDir_WS  = u_camPos_WS - vtxPos_WS;
 	viewDist_WS = length(viewDir_WS);
-    lightPos_CS = u_lightVP * vec4(vtxPos_WS, 1.0);
     colorOffset = fract(sin(dot(instPos_WS.xz, vec2(12.9898,78.233))) * 43758.5453) * 0.25; // per-blade color variation
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450 core
+precision highp float;
+
+uniform float u_material; // 0.5 trunk, 1.0 leaves, 0 stays empty
+
+in vec3 pos_OS;
+
+out vec4 fragmentColor;
+
+// ---------- Main ----------
+void main() {
+	// Same flat normal as the full-detail shaders, kept in object space
+	vec3 N = normalize(cross(dFdx(pos_OS), dFdy(pos_OS)));
+	fragmentColor = vec4(N * 0.5 + 0.5, u_material);
+}
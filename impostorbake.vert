@@ -0,0 +1,13 @@
+#version 450 core
+precision highp float;
+
+layout(location=0) in vec3 vtxPos_OS;
+
+uniform mat4 u_MVP;
+
+out vec3 pos_OS;
+
+void main() {
+    pos_OS = vtxPos_OS;
+    gl_Position = u_MVP * vec4(vtxPos_OS, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 450 core
+precision highp float;
+
+// Depth-only variant of impostorshader.frag: keeps the alpha test, skips the shading
+layout(binding = 6) uniform sampler2DArray u_impostorAtlas;
+uniform int u_layer;
+
+in vec2 atlasUV;
+
+// ---------- Main ----------
+void main() {
+	if (texture(u_impostorAtlas, vec3(atlasUV, float(u_layer))).a < 0.25) discard;
+}
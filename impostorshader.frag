@@ -0,0 +1,136 @@
+#version 450 core
+precision highp float;
+
+struct Material {
+    vec4 kd;
+    vec4 ks;
+    vec4 ka;
+    vec4 shininess_pad;
+};
+
+layout(std140, binding = 2) uniform Lighting {
+    vec4 u_lightDir;
+    vec4 u_lightLa;
+    vec4 u_lightLe;
+};
+
+layout(std140, binding = 6) uniform Materials {
+    Material materials[16];
+};
+
+#define MAT_OBJECT 3
+#define material (materials[MAT_OBJECT])
+
+layout(std140, binding = 7) uniform ColorPalette {
+    vec4 u_terrainColors[5];
+	vec4 u_angleThresholds;
+    vec4 u_grassColor;
+    vec4 u_waterColor;
+    vec4 u_skyColor;
+    vec4 u_atmosphereColor;
+    float u_fogDensity;
+};
+
+#define SHADOW_CASCADES 4
+layout(binding = 2) uniform sampler2DArray u_shadowMap;
+uniform mat4 u_cascadeVP[SHADOW_CASCADES];
+uniform vec4 u_cascadeSplits;
+uniform float u_shadowBias;
+uniform vec2 u_shadowTexel;
+
+// One layer per tree variant, rgb = object-space normal, a = material (see impostorbake.frag)
+layout(binding = 6) uniform sampler2DArray u_impostorAtlas;
+uniform int u_layer;
+
+in float viewDist_WS;
+in vec3 viewDir_WS;		
+in vec3 shadowPos_WS;
+in vec2 atlasUV;
+flat in vec2 yawCosSin;
+
+out vec4 fragmentColor;
+
+// ---------- Color helper ---------- 
+vec3 normalToColor(vec3 N) {
+	// Calculate the angle between the normal and the Y-axis
+	float angle =  N.y < 0.9999 ? degrees(acos(dot(N, vec3(0.0, 1.0, 0.0)))) : 0.0;
+
+	// Color based on tri angle
+	vec3 col = vec3(0.0);
+	if		(angle < u_angleThresholds.x)	col = mix(u_terrainColors[0].xyz, u_terrainColors[1].xyz, angle / u_angleThresholds.x);
+	else if (angle < u_angleThresholds.y)	col = mix(u_terrainColors[1].xyz, u_terrainColors[2].xyz, (angle - u_angleThresholds.x) / (u_angleThresholds.y - u_angleThresholds.x));
+	else if (angle < u_angleThresholds.z)	col = mix(u_terrainColors[2].xyz, u_terrainColors[3].xyz, (angle - u_angleThresholds.y) / (u_angleThresholds.z - u_angleThresholds.y));
+	else if (angle < u_angleThresholds.w)	col = mix(u_terrainColors[3].xyz, u_terrainColors[4].xyz, (angle - u_angleThresholds.z) / (u_angleThresholds.w - u_angleThresholds.z));
+	else								col = u_terrainColors[4].xyz;
+	return col;
+}
+
+// ---------- Shadow ----------
+float shadowMask(vec3 pos_WS, float viewDist) {
+    // First cascade whose range covers the fragment; a cascade still waiting for its refresh falls through to the next
+    for (int c = 0; c < SHADOW_CASCADES; c++) {
+        if (viewDist > u_cascadeSplits[c]) continue;
+
+        // World to light NDC
+        vec4 lightClip = u_cascadeVP[c] * vec4(pos_WS, 1.0);
+        vec3 proj = lightClip.xyz / lightClip.w;
+        vec2 uv = proj.xy * 0.5 + 0.5;
+        float depth = proj.z * 0.5 + 0.5;
+
+        // Outside map
+        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) continue;
+
+        // 3x3 PCF
+        float vis = 0.0;
+        int kernel = 1;
+        for (int dx = -kernel; dx <= kernel; ++dx) {
+            for (int dy = -kernel; dy <= kernel; ++dy) {
+                vec2 offset = vec2(dx, dy) * u_shadowTexel;
+                float closest = texture(u_shadowMap, vec3(uv + offset, float(c))).r;
+                float current = depth - u_shadowBias;
+                vis += (current <= closest) ? 1.0 : 0.0;
+            }
+        }
+
+        return vis / pow(kernel * 2 + 1, 2);
+    }
+    return 1.0;
+}
+
+// ---------- Main ----------
+void main() {
+	vec4 texel = texture(u_impostorAtlas, vec3(atlasUV, float(u_layer)));
+	if (texel.a < 0.25) discard;
+
+	// Rotate the baked normal by the instance yaw
+	vec3 N_OS = normalize(texel.rgb * 2.0 - 1.0);
+	float c = yawCosSin.x, s = yawCosSin.y;
+	vec3 N = normalize(vec3(c * N_OS.x + s * N_OS.z, N_OS.y, -s * N_OS.x + c * N_OS.z));
+
+	vec3 V = normalize(viewDir_WS);
+	vec3 L = normalize(u_lightDir.xyz);
+	vec3 H = normalize(L + V);
+	float NdotL = max(dot(N, L), 0.0);
+    float NdotH = max(dot(N, H), 0.0);
+	float spec = pow(NdotH, material.shininess_pad.x) * NdotL;
+
+	// Leaves and trunk colored like leafshader.frag / trunkshader.frag
+	vec3 texColor = (texel.a > 0.75) ? u_waterColor.xyz : normalToColor(N);
+	
+    vec3 ambient = material.ka.xyz * texColor * u_lightLa.xyz;
+	vec3 diffuse = material.kd.xyz * texColor * NdotL * u_lightLe.xyz;
+	vec3 specular = material.ks.xyz * spec * u_lightLe.xyz;
+
+    float shadow = shadowMask(shadowPos_WS, viewDist_WS);
+    vec3 radiance = ambient + (diffuse + specular) * shadow;
+
+	// Base sky gradient
+    float t = clamp(V.y*0.5 + 0.5, 0.0, 1.0);
+    vec4 skyCol = mix(u_skyColor, u_atmosphereColor, t);
+
+	// Fog
+    float fogFactor = exp(-u_fogDensity * viewDist_WS * viewDist_WS);
+    vec3 finalColor = mix(skyCol.xyz, radiance, fogFactor);
+
+	fragmentColor = vec4(finalColor, 1.0);
+}
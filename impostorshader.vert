@@ -0,0 +1,74 @@
+#version 450 core
+precision highp float;
+
+// No vertex buffer: the quad corner comes from gl_VertexID (4-vertex strip)
+layout(location=1) in vec3 instPos_WS;
+layout(location=2) in uint instYawScale; // packHalf2x16(yaw, scale)
+
+uniform vec3 u_camPos_WS;
+uniform mat4 u_V, u_P;
+
+uniform vec4 u_bounds;  // object-space center.xyz, radius in .w
+uniform int  u_frames;  // frames per atlas side
+
+invariant gl_Position;
+out vec2 atlasUV; // also needed for the depth-only alpha test
+#ifndef DEPTH_ONLY
+out float viewDist_WS;
+out vec3 viewDir_WS;
+out vec3 shadowPos_WS;
+flat out vec2 yawCosSin;
+#endif
+
+// ---------- Hemi-octahedral mapping (must match ImpostorAtlas.h) ----------
+vec2 hemiOctEncode(vec3 d) {
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    return vec2(d.x + d.z, d.x - d.z);
+}
+
+vec3 hemiOctDecode(vec2 e) {
+    float x = (e.x + e.y) * 0.5;
+    float z = (e.x - e.y) * 0.5;
+    return normalize(vec3(x, 1.0 - abs(x) - abs(z), z));
+}
+
+// Object to world rotation, same as RotateY(yaw) in instanceMatrix()
+vec3 rotY(vec3 p, float c, float s) {
+    return vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z);
+}
+
+// ---------- Main ----------
+void main() {
+    vec2 yawScale = unpackHalf2x16(instYawScale);
+    float c = cos(yawScale.x);
+    float s = sin(yawScale.x);
+
+    // View direction in object space, clamped to the baked hemisphere
+    vec3 center_WS = instPos_WS + rotY(u_bounds.xyz, c, s) * yawScale.y;
+    vec3 toCam = u_camPos_WS - center_WS;
+    vec3 d = vec3(c * toCam.x - s * toCam.z, max(toCam.y, 0.0), s * toCam.x + c * toCam.z);
+    d = normalize(d + vec3(0.0, 1e-4, 0.0));
+
+    // Nearest baked frame
+    float F = float(u_frames);
+    vec2 grid = (hemiOctEncode(d) * 0.5 + 0.5) * F;
+    vec2 frame = clamp(floor(grid), vec2(0.0), vec2(F - 1.0));
+    vec3 f = hemiOctDecode((frame + 0.5) / F * 2.0 - 1.0);
+
+    // Quad spans the frame's ortho window, basis as in LookAt(up = +Y)
+    vec3 u = normalize(cross(vec3(0.0, 1.0, 0.0), f));
+    vec3 v = cross(f, u);
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 pos_OS = u_bounds.xyz + (corner.x * u + corner.y * v) * u_bounds.w;
+
+    vec3 vtxPos_WS = instPos_WS + rotY(pos_OS, c, s) * yawScale.y;
+    gl_Position = u_P * u_V * vec4(vtxPos_WS, 1.0);
+
+    atlasUV = (frame + corner * 0.5 + 0.5) / F;
+#ifndef DEPTH_ONLY
+    yawCosSin = vec2(c, s);
+    viewDir_WS  = u_camPos_WS - vtxPos_WS;
+    viewDist_WS = length(viewDir_WS);
+    shadowPos_WS = vtxPos_WS;
+#endif
+}
@@ -8,18 +8,19 @@ class LeafShader : public Shader {
 public:
 	LeafShader() {
 		create("leafshader.vert", "leafshader.frag", "fragmentColor");
+		createDepthOnly("leafshader.vert");
 	}
 
 	void Bind(RenderState state) {
-		Use();
+		Use(state.depthOnly);
 
 		setUniform(state.V, "u_V");
 		setUniform(state.P, "u_P");
+		if (state.depthOnly) return;
+
 		setUniform(state.cameraPos, "u_camPos_WS");
 
 		// Shadow
-		setUniform(state.lightVP, "u_lightVP");
-		setUniform(state.shadowTexel, "u_shadowTexel");
-		setUniform(state.shadowBias, "u_shadowBias");
+		setShadowUniforms(state);
 	}
 };
@@ -4,19 +4,25 @@
 #include "TreeParams.h"
 
 class LeavesGeometry : public Geometry {
-    TreeParams params;
-
 public:
-    LeavesGeometry(float radius, int tesselation, int leafCount, const TreeParams& params) : params(params) {
+    LeavesGeometry(float radius, int tesselation, int leafCount, const TreeParams& params) {
+        std::vector<vec3> vtx;
+        generate(radius, tesselation, leafCount, params, vtx);
+        init(vtx);
+    }
 
-        LeafCloudGenerator gen(leafCount, radius, [this](vec3 p) { return this->sdf(p); }, tesselation, params.minLeafSize, params.maxLeafSize);
+    // Prebuilt vertex data (e.g. from the mesh cache)
+    LeavesGeometry(const std::vector<vec3>& vtx) {
+        init(vtx);
+    }
 
-        std::vector<vec3> vtx;
+    // CPU only, safe to call from worker threads
+    static void generate(float radius, int tesselation, int leafCount, const TreeParams& params, std::vector<vec3>& vtx) {
+        LeafCloudGenerator gen(leafCount, radius, [&params](vec3 p) { return sdf(params, p); }, tesselation, params.minLeafSize, params.maxLeafSize);
         gen.generate(vtx);
-        init(vtx);
     }
 
-    float sdf(vec3 p) {
+    static float sdf(const TreeParams& params, vec3 p) {
         vec3 pLeaves1 = p - params.branch1EndPos;
         vec3 pLeaves2 = p - params.branch2EndPos;
 
@@ -26,11 +32,11 @@ public:
         return crown;
     }
 
-    float sdSphere(vec3 p, float r) {
+    static float sdSphere(vec3 p, float r) {
         return length(p) - r;
     }
 
-    float displace(vec3 p) {
+    static float displace(vec3 p) {
         float baseFreq = 0.05f;
         float baseAmpl = 10.0f;
         float warpFreq = 0.15f;
@@ -48,7 +54,7 @@ public:
         return n * baseAmpl;
     }
 
-    float opSmoothUnion(float d1, float d2, float k) {
+    static float opSmoothUnion(float d1, float d2, float k) {
         k *= 4.0f;
         float h = max(k - fabsf(d1 - d2), 0.0f);
         return min(d1, d2) - h * h * 0.25f / k;
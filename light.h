@@ -1,5 +1,6 @@
 #pragma once
 #include "framework.h"
+#include "StreamBuffer.h"
 
 struct LightData {
 	vec4 dir;
@@ -9,17 +10,9 @@ struct LightData {
 
 struct Light {
 	LightData data;
-	GLuint lightingUBO = 0;
 
-	void InitUBO() {
-		glGenBuffers(1, &lightingUBO);
-		glBindBuffer(GL_UNIFORM_BUFFER, lightingUBO);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(LightData), &data, GL_DYNAMIC_DRAW);
-		glBindBufferRange(GL_UNIFORM_BUFFER, 2, lightingUBO, 0, sizeof(LightData)); // Binding = 2
-	}
-
-	void UpdateUBO() const {
-		glBindBuffer(GL_UNIFORM_BUFFER, lightingUBO);
-		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightData), &data);
+	// Every frame: ring memory does not outlive it
+	void UpdateUBO(StreamBuffer& stream) const {
+		stream.bind(GL_UNIFORM_BUFFER, 2, &data, sizeof(LightData)); // Binding = 2
 	}
 };
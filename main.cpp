@@ -82,6 +82,14 @@ int main(int, char**) {
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         glfwSwapBuffers(window);
+
+        // Time to first frame, measured from glfwInit
+        static bool firstFrame = true;
+        if (firstFrame) {
+            firstFrame = false;
+            printf("Time to first frame: %.2f s\n", glfwGetTime());
+            scene.setFirstFrameTime((float)glfwGetTime());
+        }
     }
 
     // Cleanup
@@ -24,7 +24,9 @@ public:
 		state.M = TranslateMatrix(pos) * rotation.toRotationMatrix() * ScaleMatrix(scale);
 		state.MVP = state.P * state.V * state.M;
 		shader->Bind(state);
-		geometry->Draw();
+
+		float maxScale = max(scale.x, max(scale.y, scale.z));
+		geometry->Draw(geometry->selectLod(length(pos - state.cameraPos), state.P, maxScale));
 	}
 
 	void SetRotation(Quaternion rot) {
@@ -8,18 +8,19 @@ class ObjectShader : public Shader {
 public:
 	ObjectShader() {
 		create("objectshader.vert", "objectshader.frag", "fragmentColor");
+		createDepthOnly("objectshader.vert");
 	}
 
 	void Bind(RenderState state) {
-		Use();
+		Use(state.depthOnly);
+
+		setUniform(state.MVP, "u_MVP");
+		if (state.depthOnly) return;
 
 		setUniform(state.cameraPos, "u_camPos_WS");
 		setUniform(state.M, "u_M");
-		setUniform(state.MVP, "u_MVP");
 
 		// Shadow
-		setUniform(state.lightVP, "u_lightVP");
-		setUniform(state.shadowTexel, "u_shadowTexel");
-		setUniform(state.shadowBias, "u_shadowBias");
+		setShadowUniforms(state);
 	}
 };
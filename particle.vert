@@ -1,5 +1,8 @@
 #version 450 core
 
+uniform mat4 u_V;
+uniform mat4 u_P;
+
 struct Particle {
     vec4 pos;
     vec4 vel;
@@ -7,27 +10,34 @@ struct Particle {
     vec4 ext; // x=age, y=lifetime, z=size, w=type
 };
 
-layout(std430, binding = 0) buffer Particles {
+layout(std430, binding = 0) readonly buffer Particles {
     Particle particles[];
 };
 
-out VS_OUT {
-    vec3 pos_WS;
-    vec4 color;
-    float age;
-    float life;
-    float size;
-    float type;
-} vout;
+// Live particle indices, back to front when sorted
+layout(std430, binding = 1) readonly buffer AliveList {
+    uint alive[];
+};
+
+out vec2 fragUV;
+out vec4 fragColor;
+out float normalizedAge;
 
+// One instance per live particle, one triangle strip vertex per billboard corner
 void main() {
-    uint id = uint(gl_VertexID);
+    uint id = alive[gl_InstanceID];
     Particle p = particles[id];
 
-    vout.pos_WS = p.pos.xyz;
-    vout.color = p.col;
-    vout.age = p.ext.x;
-    vout.life = p.ext.y;
-    vout.size = p.ext.z;
-    vout.type = p.ext.w;
+    vec2 uv = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec3 up = vec3(0.0, 1.0, 0.0);
+    vec3 right = vec3(1.0, 0.0, 0.0);
+    float halfSize = 0.5 * p.ext.z;
+
+    vec4 camPos_VS = u_V * vec4(p.pos.xyz, 1.0);
+    vec3 corner = camPos_VS.xyz + ((uv.x * 2.0 - 1.0) * right + (uv.y * 2.0 - 1.0) * up) * halfSize;
+    gl_Position = u_P * vec4(corner, 1.0);
+
+    fragUV = uv;
+    fragColor = p.col;
+    normalizedAge = clamp(p.ext.x / p.ext.y, 0.0, 1.0);
 }
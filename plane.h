@@ -10,8 +10,9 @@ public:
     PlaneGeometry(float scale, int tesselation) : scale(scale), tesselation(tesselation) {
         ParametricMeshGenerator meshGen(tesselation, [this](float u, float v) { return this->eval(u, v); });
         std::vector<vec3> vtxData;
-        meshGen.generate(vtxData);
-        init(vtxData); // upload to GPU
+        std::vector<uint32_t> idxData;
+        meshGen.generate(vtxData, idxData);
+        init(vtxData, idxData); // upload to GPU
     }
 
     vec3 eval(float u, float v) const {
@@ -3,12 +3,14 @@ precision highp float;
 
 uniform sampler2D u_sceneColor;
 uniform sampler2D u_sceneDepth;
+uniform sampler2D u_bloom;      // half-res sum of the bloom chain
+uniform sampler2D u_dofBlur;    // half-res gather, valid around out-of-focus tiles
+uniform sampler2D u_dofTiles;   // max CoC per tile
+uniform int   u_bloomLevels;
 uniform float u_near;
 uniform float u_far;
 uniform float u_focusDist;
 uniform float u_focusRange;
-uniform float u_bloomThreshold;
-uniform float u_bloomSoftKnee;
 uniform float u_bloomIntensity;
 uniform float u_saturation;
 uniform float u_vibrance;
@@ -17,8 +19,8 @@ in vec2 uv;
 
 out vec4 fragmentColor;
 
-const int   DOF_KERNEL_SIZE = 1;
-const float MAX_COC = 2.0;
+#define DOF_TILE_SIZE 16
+const float MAX_COC = 8.0;      // matches dof_gather.comp
 
 // ---------- Utility ----------
 float linearizeDepth(float depthNonLinear) {
@@ -45,64 +47,32 @@ vec3 applyVibrance(vec3 color, float vibranceAmount) {
     return applySaturation(color, adjustedSaturation);
 }
 
-float computeBloomMask(float brightness, float threshold, float knee) {
-    float kneeValue = threshold * knee;
-    float diff = max(brightness - threshold + kneeValue, 0.0);
-    return clamp((diff * diff) / (kneeValue * kneeValue), 0.0, 1.0);
+float circleOfConfusion(float depthNonLinear) {
+    float coc = (abs(linearizeDepth(depthNonLinear) - u_focusDist) - u_focusRange) / u_focusRange;
+    return clamp(coc, 0.0, 1.0);
 }
 
 // ---------- Bloom ----------
+// The up chain adds every level, so divide by their count
 vec3 sampleBloom(vec2 uvCoords) {
-    // Base scene color and bright-pass mask
-    vec3 baseColor = textureLod(u_sceneColor, uvCoords, 0.0).rgb;
-    float bloomMask = computeBloomMask(computeLuminance(baseColor), u_bloomThreshold, u_bloomSoftKnee);
-
-    vec3 accumulatedBloom = vec3(0.0);
-    float totalWeight = 0.0;
-
-    // Sample lower mips for blur contribution
-    for (int mipLevel = 1; mipLevel <= 10; ++mipLevel) {
-        float mipWeight = pow(1.8, float(mipLevel - 1));
-        vec3 mipColor = textureLod(u_sceneColor, uvCoords, float(mipLevel)).rgb;
-        accumulatedBloom += mipColor * mipWeight;
-        totalWeight += mipWeight;
-    }
-
-    vec3 averagedBloom = (totalWeight > 0.0)
-        ? (accumulatedBloom / totalWeight)
-        : vec3(0.0);
-
-    return averagedBloom * bloomMask;
+    return texture(u_bloom, uvCoords).rgb / float(max(u_bloomLevels, 1));
 }
 
 // ---------- Main ----------
 void main() {
-    // Depth of Field
-    vec2 texelSize = 1.0 / vec2(textureSize(u_sceneColor, 0));
-
-    float depthSample = texture(u_sceneDepth, uv).r;
-    float linearDepth = linearizeDepth(depthSample);
-
-    float circleOfConfusion = (abs(linearDepth - u_focusDist) - u_focusRange) / u_focusRange;
-    circleOfConfusion = clamp(circleOfConfusion, 0.0, 1.0);
-    float blurRadius = circleOfConfusion * MAX_COC;
-
-    vec4 dofColorAccumulator = vec4(0.0);
-    for (int x = -DOF_KERNEL_SIZE; x <= DOF_KERNEL_SIZE; ++x) {
-        for (int y = -DOF_KERNEL_SIZE; y <= DOF_KERNEL_SIZE; ++y) {
-            vec2 offset = vec2(x, y) * texelSize * blurRadius;
-            dofColorAccumulator += texture(u_sceneColor, uv + offset);
-        }
+    // Depth of Field: in-focus tiles keep the sharp scene, the rest blend in the half-res gather
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 dofColor = texelFetch(u_sceneColor, pixel, 0).rgb;
+    if (texelFetch(u_dofTiles, pixel / DOF_TILE_SIZE, 0).r > 0.0) {
+        float blurRadius = circleOfConfusion(texelFetch(u_sceneDepth, pixel, 0).r) * MAX_COC;
+        dofColor = mix(dofColor, texture(u_dofBlur, uv).rgb, clamp(blurRadius, 0.0, 1.0));
     }
 
-    float kernelArea = float((DOF_KERNEL_SIZE * 2 + 1) * (DOF_KERNEL_SIZE * 2 + 1));
-    dofColorAccumulator /= kernelArea;
-
     // Bloom
     vec3 bloomColor = sampleBloom(uv) * u_bloomIntensity;
 
     // Combine
-    vec3 combinedColor = dofColorAccumulator.rgb + bloomColor;
+    vec3 combinedColor = dofColor + bloomColor;
 
     // Color Grading
     combinedColor = applyVibrance(combinedColor, u_vibrance);
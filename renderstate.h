@@ -1,6 +1,8 @@
 #pragma once
 #include "framework.h"
 
+constexpr int SHADOW_CASCADES = 4;
+
 struct RenderState {
 	float time;
 	vec3 cameraPos;
@@ -10,9 +12,13 @@ struct RenderState {
 	mat4 invP;
 	vec3 chunkId;
 	float chunkSize;
+	float waterCell;        // cell size of the finest water clipmap level
+	bool depthOnly = false; // shaders bind their depth-only variant (shadow pass, depth prepass)
+	bool shadowPass = false; // draw everything in range, the camera's GPU cull results do not apply
 
 	// Shadow params
-	mat4  lightVP;
+	mat4  cascadeVP[SHADOW_CASCADES];
+	vec4  cascadeSplits; // far view distance of each cascade
 	vec2  shadowTexel;
 	float shadowBias;
 
@@ -10,20 +10,24 @@
 #include "material.h"
 #include "trunkshader.h"
 #include "leafshader.h"
+#include "ImpostorShader.h"
 #include "InstanceShader.h"
 #include "PostProcessShader.h"
 #include "watershader.h"
 #include "terrainshader.h"
-#include "plane.h"
+#include "clipmap.h"
 #include "cactus.h"
 #include "trunk.h"
 #include "leaves.h"
+#include "TreeVariants.h"
 #include "SharedResources.h"
 #include "WorldConfig.h"
 #include "FPSCounter.h"
 #include "ShadowMap.h"
+#include "GpuTimer.h"
 #include "RenderTarget.h"
-#include "ReflectionBuffer.h"
+#include "StreamBuffer.h"
+#include "WaterSSR.h"
 #include "PostProcessor.h"
 #include "ParticleSystem.h";
 
@@ -44,16 +48,35 @@ class Scene {
 	ColorPalette* palette;
 	MaterialUBO materialsUBO;
 	SharedResources resources;
+	StreamBuffer stream;        // per-frame uploads: light, palette, terrain params, particle emitters
 	
-	RenderTarget sceneTarget;
-	ReflectionBuffer reflection;
+	RenderTarget sceneTarget;   // ping-pong: water reflections read last frame's set
+	WaterSSR waterSSR;
 	PostProcessor post;
 
 	ShadowMap shadow;
-	mat4 lightV, lightP, lightVP;
+	mat4 cascadeV[SHADOW_CASCADES], cascadeP[SHADOW_CASCADES];
+
+	// Shadow cache: a cascade keeps its static layer until its snapped center moves or a chunk under it changes
+	vec3 cascadeCenter[SHADOW_CASCADES];
+	bool cascadeValid[SHADOW_CASCADES] = {};
+	bool cascadeStale[SHADOW_CASCADES] = {};
+	int  cascadeAge[SHADOW_CASCADES] = {};         // frames since the static layer was drawn
+	bool cascadeHasDynamic[SHADOW_CASCADES] = {};  // live layer holds dynamic casters on top of the static one
+	int  cascadeDynamicRect[SHADOW_CASCADES][4] = {}; // their texel footprint x0, y0, x1, y1
+	int  shadowCascadesDrawn = 0;                   // static layers redrawn this frame
+	bool shadowDepthShaders = true;                 // depth-only variants in the shadow pass
+	GpuTimer shadowTimer;
+
+	bool depthPrepass = true;   // opaque depth first, color pass with GL_EQUAL
+	GpuTimer sceneTimer;        // opaque + sky
 
 	ParticleSystem* particleSystem;
 
+	// Startup timing
+	TreeBuildStats treeStats;
+	float firstFrameTime = 0.0f;
+
 
 	void updateState(RenderState& state) {
 		state.time = glfwGetTime();
@@ -68,21 +91,154 @@ class Scene {
 	}
 
 
-	void updateLightMatrices() {
-		// Focus the shadow box around the camera
+	// Cascade c covers everything within splits[c] of the camera. Boxes are centered on the camera rather
+	// than fitted to a frustum slice, so turning never invalidates them; only moving past a snap step does.
+	void cascadeFit(float split, const vec3& lightDir, vec3& center, float& radius) const {
+		// Grow the box by two snap steps so a cached layer still covers the camera while its refresh waits
+		float step = split / 16.0f;
+		radius = ceilf(split + 2.0f * step);
+		float texel = 2.0f * radius / shadow.width;
+		step = max(1.0f, roundf(step / texel)) * texel; // whole texels, so edges do not shimmer
+
+		mat4 lightRot = LookAt(vec3(0.0f), lightDir, vec3(0.0f, 1.0f, 0.0f));
 		vec3 camPos = camera->getPos();
-		vec3 center = vec3(floor(camPos.x / cfg.chunkSize), 0.0f, floor(camPos.z / cfg.chunkSize)) * cfg.chunkSize;
+		vec4 lc = lightRot * vec4(camPos.x, camPos.y, camPos.z, 1.0f);
+		lc.x = roundf(lc.x / step) * step;
+		lc.y = roundf(lc.y / step) * step;
+		lc.z = roundf(lc.z / step) * step;
+		vec4 snapped = TransposeMatrix(lightRot) * lc;
+		center = vec3(snapped.x, snapped.y, snapped.z);
+	}
+
+	// Texel rect of a sphere in an ortho cascade, padded by a texel for rasterization
+	void shadowFootprint(const mat4& cascadeVP, float cascadeRadius, const vec3& center, float radius, int rect[4]) {
+		vec4 ndc = cascadeVP * vec4(center.x, center.y, center.z, 1.0f);
+		float r = radius / cascadeRadius;
+		rect[0] = max(0, min(shadow.width, (int)floorf((ndc.x - r) * 0.5f * shadow.width + 0.5f * shadow.width) - 1));
+		rect[1] = max(0, min(shadow.height, (int)floorf((ndc.y - r) * 0.5f * shadow.height + 0.5f * shadow.height) - 1));
+		rect[2] = max(0, min(shadow.width, (int)ceilf((ndc.x + r) * 0.5f * shadow.width + 0.5f * shadow.width) + 1));
+		rect[3] = max(0, min(shadow.height, (int)ceilf((ndc.y + r) * 0.5f * shadow.height + 0.5f * shadow.height) + 1));
+	}
+
+	// Amortized shadow update: the nearest cascade is drawn every frame at a constant cost, the others
+	// are cached and at most one of them is redrawn per frame
+	void updateShadows() {
+		const float n = camera->getNearPlane();
+		const float f = camera->getFarPlane();
+		const float lambda = 0.75f; // log/uniform split blend
+		const float pad = 1500.0f; // room for casters between the light and the box
+		const float playerRadius = 10.0f;
+		const float playerShadowReach = 50.0f; // how far from the player its shadow can land
+
 		vec3 lightDir = -vec3(sun.data.dir.x, sun.data.dir.y, sun.data.dir.z);
-		vec3 lightPos = center - lightDir * 1200.0f; // pull back enough to see the box
-		float halfSize = 2400.0f; // covers this much around camera
-		float halfHeight = 2400.0f;
-		float nearPlane = camera->getNearPlane();
-		float farPlane = camera->getFarPlane();
-
-		// Build matrices
-		lightV = LookAt(lightPos, center, vec3(0.0f, 1.0f, 0.0f));
-		lightP = Ortho(-halfSize, halfSize, -halfHeight, halfHeight, nearPlane, farPlane);
-		lightVP = lightP * lightV;
+		std::vector<AABB> changed = chunkManager->TakeChangedBounds();
+
+		// Practical split scheme, radial distances (the shaders compare viewDist)
+		float splits[SHADOW_CASCADES];
+		for (int c = 0; c < SHADOW_CASCADES; c++) {
+			float t = float(c + 1) / SHADOW_CASCADES;
+			splits[c] = lambda * n * powf(f / n, t) + (1.0f - lambda) * (n + (f - n) * t);
+		}
+		state.cascadeSplits = vec4(splits[0], splits[1], splits[2], splits[3]);
+
+		// Find stale cascades
+		vec3 centers[SHADOW_CASCADES];
+		float radii[SHADOW_CASCADES];
+		for (int c = 0; c < SHADOW_CASCADES; c++) {
+			cascadeFit(splits[c], lightDir, centers[c], radii[c]);
+			if (!cascadeValid[c] || length(centers[c] - cascadeCenter[c]) > 0.5f) cascadeStale[c] = true;
+			if (cascadeValid[c] && !cascadeStale[c] && !changed.empty()) {
+				FrustumPlanes planes = frustumPlanesFromVP(state.cascadeVP[c]);
+				for (const AABB& b : changed) {
+					if (aabbInFrustum(b, planes)) { cascadeStale[c] = true; break; }
+				}
+			}
+			cascadeAge[c]++;
+		}
+
+		// Pick this frame's static redraws
+		bool redraw[SHADOW_CASCADES] = {};
+		redraw[0] = true; // snaps every few frames at speed, so it is never cached
+		int oldest = -1;
+		for (int c = 1; c < SHADOW_CASCADES; c++) {
+			if (!cascadeValid[c]) redraw[c] = true; // nothing cached yet
+			else if (cascadeStale[c] && (oldest < 0 || cascadeAge[c] > cascadeAge[oldest])) oldest = c;
+		}
+		if (oldest >= 0) redraw[oldest] = true;
+
+		glViewport(0, 0, shadow.width, shadow.height);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(10.0f, 1.0f); // removes shadow acne
+
+		// Render with light matrices, save camera matrices
+		shadowTimer.begin();
+		mat4 camV = state.V, camP = state.P;
+		state.depthOnly = shadowDepthShaders;
+		state.shadowPass = true;
+		state.shadowTexel = vec2(1.0f / shadow.width, 1.0f / shadow.height);
+		state.shadowBias = 0.0025f;
+
+		shadowCascadesDrawn = 0;
+		for (int c = 0; c < SHADOW_CASCADES; c++) {
+			if (redraw[c]) {
+				// Static casters (skip skydome), culled by the cascade's light frustum
+				cascadeCenter[c] = centers[c];
+				vec3 lightPos = centers[c] - lightDir * (radii[c] + pad);
+				cascadeV[c] = LookAt(lightPos, centers[c], vec3(0.0f, 1.0f, 0.0f));
+				cascadeP[c] = Ortho(-radii[c], radii[c], -radii[c], radii[c], 0.0f, 2.0f * radii[c] + pad);
+				state.cascadeVP[c] = cascadeP[c] * cascadeV[c];
+				state.V = cascadeV[c];
+				state.P = cascadeP[c];
+
+				// The live cascade is drawn straight into the sampled layer
+				if (c == 0) shadow.bindCascade(c);
+				else shadow.bindStatic(c);
+				glClear(GL_DEPTH_BUFFER_BIT);
+				chunkManager->DrawChunks(state, frustumPlanesFromVP(state.cascadeVP[c]));
+
+				cascadeValid[c] = true;
+				cascadeStale[c] = false;
+				cascadeAge[c] = 0;
+				shadowCascadesDrawn++;
+			}
+
+			// Dynamic casters go on top of the static layer, only in cascades whose view-distance slice holds
+			// receivers their shadow can reach. Outside last frame's footprint the layer is still the static copy.
+			float sliceNear = c == 0 ? 0.0f : splits[c - 1];
+			float playerDist = length(player->getPos() - camera->getPos());
+			bool inSlice = playerDist - playerShadowReach < splits[c] && playerDist + playerShadowReach > sliceNear;
+			bool hasDynamic = controlMode == ControlMode::Player && inSlice && sphereInFrustum(player->getPos(), playerRadius, frustumPlanesFromVP(state.cascadeVP[c]));
+
+			if (c > 0) {
+				if (redraw[c]) shadow.restoreStatic(c);
+				else if (cascadeHasDynamic[c]) shadow.restoreStatic(c, cascadeDynamicRect[c]);
+			}
+			if (hasDynamic) {
+				state.V = cascadeV[c];
+				state.P = cascadeP[c];
+				shadow.bindCascade(c);
+				player->Draw(state);
+				shadowFootprint(state.cascadeVP[c], radii[c], player->getPos(), playerRadius, cascadeDynamicRect[c]);
+			}
+			cascadeHasDynamic[c] = hasDynamic;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		// Restore state
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		state.depthOnly = false;
+		state.shadowPass = false;
+		state.V = camV;
+		state.P = camP;
+		shadowTimer.end();
+
+		// Bind shadow texture
+		glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D_ARRAY, shadow.depthTex);
+	}
+
+	void drawOpaque() {
+		chunkManager->DrawChunks(state, *camera);
+		if (controlMode == ControlMode::Player) player->Draw(state);
 	}
 
 public:
@@ -95,91 +251,115 @@ public:
 		float deltaTime = fpsCounter.getDeltaTime();
 		updateState(state);
 
+		// Per-frame uploads go to the next ring region; the blocks every shader reads are bound first
+		stream.beginFrame();
+		sun.UpdateUBO(stream);
+		palette->updatePaletteUBO(stream);
+
 		// Update chunks and movement
 		chunkManager->Update(camera->getPos());
 		switch (controlMode) {
 			case ControlMode::Freecam: camera->move(deltaTime); break;
 			case ControlMode::Player:  player->Update(deltaTime); break;
 		}
-		particleSystem->Update(state.time, deltaTime, player->getPos(), player->getForward());
+		// Particles collide with last frame's depth, which the Hi-Z was built from
+		const HiZBuffer& prevDepth = resources.culler->hiZ;
+		particleSystem->Update(state.time, deltaTime, player->getPos(), player->getForward(), camera->getFrustumPlanes(), camera->getPos(), prevDepth.valid ? sceneTarget.depth : 0, prevDepth.viewProj);
 		
-		if (fpsCounter.getFrameCount() % 10 == 0) {
-			// Shadow pass
-			glViewport(0, 0, shadow.width, shadow.height);
-			glBindFramebuffer(GL_FRAMEBUFFER, shadow.fbo);
-			glClear(GL_DEPTH_BUFFER_BIT);
-			glEnable(GL_POLYGON_OFFSET_FILL);
-			glPolygonOffset(10.0f, 1.0f); // removes shadow acne
-
-			// Render with light matrices, save camera matrices
-			mat4 prevV = state.V, prevP = state.P;
-
-			// Shadow uniforms
-			updateLightMatrices();
-			state.V = lightV;
-			state.P = lightP;
-			state.lightVP = lightVP;
-			state.shadowTexel = vec2(1.0f / shadow.width, 1.0f / shadow.height);
-			state.shadowBias = 0.0025f;
-
-			// Draw shadow casters (skip skydome)
-			chunkManager->DrawChunks(state, *camera);
-			if (controlMode == ControlMode::Player) player->Draw(state);
-
-			// Restore state
-			glDisable(GL_POLYGON_OFFSET_FILL);
-			state.V = prevV;
-			state.P = prevP;
-
-			// Bind shadow texture
-			glActiveTexture(GL_TEXTURE2); glBindTexture(GL_TEXTURE_2D, shadow.depthTex);
-		}
+		// Shadow pass
+		updateShadows();
 
-		// Bind scene target
+		// GPU visibility for this frame's camera draws, against last frame's depth
+		resources.culler->Cull(state);
+
+		// Bind scene target; last frame's color and depth stay readable in the other set
+		sceneTarget.swap();
 		sceneTarget.bind();
 		glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Draw calls (normal camera)
+		sceneTimer.begin();
+		if (depthPrepass) {
+			// Opaque depth first, with the depth-only variants
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			state.depthOnly = true;
+			drawOpaque();
+			state.depthOnly = false;
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+			// Then shade only the surviving surface
+			glDepthFunc(GL_EQUAL);
+			glDepthMask(GL_FALSE);
+		}
+		drawOpaque();
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+
+		// Sky last, at the far plane, so early-z leaves only uncovered pixels
 		skyDome->Draw(state);
-		chunkManager->DrawChunks(state, *camera);
-		if (controlMode == ControlMode::Player) player->Draw(state);
+		sceneTimer.end();
+
+		// Occluder depth for next frame's cull (water and particles are not occluders)
+		resources.culler->BuildHiZ(sceneTarget.depth, WINDOW_WIDTH, WINDOW_HEIGHT, state.P * state.V);
+
+		// Water reflections: half-res surface, Hi-Z trace and resolve, then back to the scene target
+		waterSSR.run(state, [&]() { chunkManager->DrawWaterSurface(state); }, sceneTarget.prevColor, sceneTarget.prevDepth, sceneTarget.depth, resources.culler->hiZ);
+		sceneTarget.bind();
+		glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
-		// SSR inputs for water relfections
-		reflection.copyDepthFrom(sceneTarget.depth, WINDOW_WIDTH, WINDOW_HEIGHT);
-		glActiveTexture(GL_TEXTURE3); glBindTexture(GL_TEXTURE_2D, reflection.prevSceneColor);
-		glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_2D, reflection.sceneDepthCopy);
+		// Water inputs: opaque depth for foam and transparency, resolved reflections.
+		// The depth is still attached, so water shades without depth writes behind a texture barrier.
+		glTextureBarrier();
+		glActiveTexture(GL_TEXTURE4); glBindTexture(GL_TEXTURE_2D, sceneTarget.depth);
+		glActiveTexture(GL_TEXTURE5); glBindTexture(GL_TEXTURE_2D, waterSSR.result());
 
-		// Draw water
+		// Draw water, then its depth alone, so DoF and particles see the surface
+		glDepthMask(GL_FALSE);
+		chunkManager->DrawWater(state);
+		glDepthMask(GL_TRUE);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		state.depthOnly = true;
 		chunkManager->DrawWater(state);
+		state.depthOnly = false;
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-		// Draw particles
+		// Draw particles, sorted and blended; without depth writes, so they never collide with themselves
+		glDepthMask(GL_FALSE);
 		particleSystem->Draw(state);
+		glDepthMask(GL_TRUE);
 
 		// Unbind scene target
 		sceneTarget.unbind();
 
-		// Update prevSceneColor for next frame
-		reflection.updatePrevColor(sceneTarget.color, WINDOW_WIDTH, WINDOW_HEIGHT);
-
 		// Post-process
 		post.run(state, sceneTarget.color, sceneTarget.depth, WINDOW_WIDTH, WINDOW_HEIGHT);
 
 		// Draw GUI
 		drawGUI(WINDOW_WIDTH - GUI_WIDTH, 0, GUI_WIDTH, GUI_HEIGHT);
+
+		// GUI edits upload too (terrain params), so the region is fenced last
+		stream.endFrame();
 	}
 
 	void Build() {
+		// Stream memory for the load-time uploads below and every frame after
+		stream.create();
+		resources.stream = &stream;
+
 		// Post-processing and SSR
 		post.init();
-		sceneTarget.create(WINDOW_WIDTH, WINDOW_HEIGHT);
-		reflection.create(WINDOW_WIDTH, WINDOW_HEIGHT);
+		sceneTarget.create(WINDOW_WIDTH, WINDOW_HEIGHT, true);
+		waterSSR.create(WINDOW_WIDTH, WINDOW_HEIGHT);
 
 		// Shadow map
 		shadow.init();
+		shadowTimer.init();
+		sceneTimer.init();
 
 		// Color palette
 		palette = new ColorPalette();
+		palette->updatePaletteUBO(stream);
 
 		// Materials
 		Material terrainMat{ vec4(0.5f,0.5f,0.5f,0.0f), vec4(0.4f,0.4f,0.4f,0.0f), vec4(0.4f,0.4f,0.4f,0.0f), vec4(1.0f) };
@@ -197,7 +377,7 @@ public:
 		sun.data.dir = vec4(normalize(vec3(0.5f, 0.6f, -0.2f)), 0.0f);
 		sun.data.la = vec4(0.8f, 0.8f, 0.8f, 0.0f);
 		sun.data.le = vec4(0.6f, 0.6f, 0.6f, 0.0f);
-		sun.InitUBO();
+		sun.UpdateUBO(stream);
 
 		// Terrain Data
 		terrainData.bedrockFrequency = 0.0015f;
@@ -226,28 +406,42 @@ public:
 		// Shared Shaders
 		resources.terrainShader		= new TerrainShader();
 		resources.waterShader		= new WaterShader();
+		resources.waterSurfaceShader = new WaterSurfaceShader();
 		resources.instanceShader	= new InstanceShader();
 		resources.treeTrunkShader	= new TrunkShader();
 		resources.treeLeafShader	= new LeafShader();
+		resources.treeImpostorShader = new ImpostorShader();
 		resources.marchingCubesCS	= new MarchingCubesCS();
 		resources.groundDistanceCS	= new GroundDistanceCS();
-		resources.terrainHeightCS	= new TerrainHeightCS();
+		resources.treeScatterCS		= new TreeScatterCS();
 
 		// Shared Geometries
-		resources.waterGeom	= new PlaneGeometry(cfg.chunkSize * (2 * cfg.renderDist + 1), cfg.tesselation * (2 * cfg.renderDist + 1));
+		// Water clipmap: terrain-density cells near the camera, levels until the rings reach past the loaded chunks
+		state.waterCell = cfg.chunkSize / cfg.tesselation;
+		int waterLevels = 1;
+		while (WATER_RING_CELLS * state.waterCell * float(1 << (waterLevels - 1)) < cfg.chunkSize * (cfg.renderDist + 1)) waterLevels++;
+		resources.waterGeom	= new ClipmapGeometry(WATER_RING_CELLS, waterLevels);
 
-		for (int i = 0; i < 10; i++) {
-			TreeParams treeParams(i);
-			resources.treeTrunkGeoms.push_back(new TrunkGeometry(128.0f, 32, treeParams));
-			resources.treeCrownGeoms.push_back(new LeavesGeometry(200.0f, 64, 3600, treeParams));
-		}
+		// Tree variants: cached on disk, generated in parallel on a miss
+		treeStats = BuildTreeVariants(TreeVariantSettings(), resources.treeTrunkGeoms, resources.treeCrownGeoms);
+
+		// Distant tree views, needs the meshes above
+		resources.treeImpostors = new ImpostorAtlas();
+		resources.treeImpostors->bake(resources.treeTrunkGeoms, resources.treeCrownGeoms);
+
+		// Chunk culling, one slot per chunk in render distance; needs the tree meshes for their bounds
+		int slots = (2 * cfg.renderDist + 1) * (2 * cfg.renderDist + 1);
+		resources.culler = new OcclusionCuller(slots, resources.treeTrunkGeoms, resources.treeCrownGeoms, resources.treeImpostors != nullptr, InstanceField::MAX_PER_CHUNK);
 
 		skyDome = new SkyDome();
 		chunkManager = new ChunkManager(&cfg, &resources);
 		camera = new Camera();
 		camera->setPos(chunkManager->getSpawnPoint());
 		player = new Player(camera, chunkManager);
-		particleSystem = new ParticleSystem();
+		particleSystem = new ParticleSystem(&stream);
+
+		// Load-time uploads count as frame 0
+		stream.endFrame();
 	}
 
 	void drawGUI(int x, int y, int w, int h) {
@@ -264,20 +458,55 @@ public:
 		// FPS and Coordinates
 		ImGui::Text("FPS: %d, AVG: %.1f", fpsCounter.getFPS(), fpsCounter.getAverageFPS());
 		ImGui::Text("X: %.1f, Y: %.1f, Z: %.1f", camera->getPos().x, camera->getPos().y, camera->getPos().z);
+		ImGui::Text("First frame: %.2f s, Trees: %.2f s (%d cached)", firstFrameTime, treeStats.seconds, treeStats.cached);
+		ImGui::Text("Shadow cascades redrawn: %d / %d, GPU: %.2f ms", shadowCascadesDrawn, SHADOW_CASCADES, shadowTimer.getMs());
+		ImGui::Checkbox("Depth-only shadow shaders", &shadowDepthShaders);
+		ImGui::Text("Opaque + sky GPU: %.2f ms", sceneTimer.getMs());
+		ImGui::Text("Stream uploads: %zu B / frame, %d fence waits", stream.bytesLastFrame, stream.waitsLastFrame);
+		ImGui::Checkbox("Depth prepass", &depthPrepass);
+		ImGui::Text("Water SSR GPU: %.2f ms, %.1f ns / %.1f Hi-Z steps per px", waterSSR.timer.getMs(), waterSSR.getNsPerPixel(), waterSSR.getStepsPerPixel());
+		const ChunkVisibility& cpuCull = chunkManager->getVisibility();
+		ImGui::Text("CPU cull: %d nodes, %d chunk boxes tested", cpuCull.nodesTested, cpuCull.boxesTested);
+		const CullCounters& cull = resources.culler->getCounters();
+		ImGui::Text("Chunks visible: %u / %u", cull.chunksVisible, cull.chunks);
+		ImGui::Text("Grass tiles: %u / %u, blades: %u / %u", cull.grassTilesVisible, cull.grassTiles, cull.bladesVisible, cull.blades);
+		ImGui::Text("Trees visible: %u / %u", cull.treesVisible, cull.trees);
+		ImGui::Checkbox("Occlusion culling", &resources.culler->enabled);
+		if (treeStats.trunkLodTriangles.size() >= 4)
+			ImGui::Text("Trunk LOD tris: %zu / %zu / %zu / %zu", treeStats.trunkLodTriangles[0], treeStats.trunkLodTriangles[1], treeStats.trunkLodTriangles[2], treeStats.trunkLodTriangles[3]);
 
 		// Color Palette
 		if (palette) {
 			if (palette->DrawImGui("Colors")) {}
 		}
 
+		ImGui::SeparatorText("Trees");
+		ImGui::SliderFloat("Impostor Distance", &cfg.impostorDist, 0.0f, 3000.0f);
+
+		ImGui::SeparatorText("Particles");
+		ImGui::Text("Drawn: %u / %d, GPU: %.2f ms", particleSystem->aliveCount, particleSystem->getMaxParticles(), particleSystem->drawTimer.getMs());
+		ImGui::Text("Emission GPU: %.2f ms", particleSystem->emitTimer.getMs());
+		ImGui::Text("Update GPU: %.2f ms, %.2f ms per M drawn", particleSystem->updateTimer.getMs(), particleSystem->updateTimer.getMs() * 1e6f / max(1.0f, (float)particleSystem->aliveCount));
+		ImGui::Checkbox("Collide with depth", &particleSystem->collideDepth);
+		ImGui::SameLine();
+		ImGui::Checkbox("Collide with bedrock", &particleSystem->collideBedrock);
+		ImGui::Combo("Ambient response", &particleSystem->response[0], "Bounce\0Stick\0Kill\0");
+		ImGui::Combo("Trail response", &particleSystem->response[1], "Bounce\0Stick\0Kill\0");
+		ImGui::Checkbox("Depth sort", &particleSystem->depthSort);
+		ImGui::Text("Sort GPU: %.2f ms (%u keys)", particleSystem->sorter.timer.getMs(), particleSystem->aliveCount);
+		ImGui::SliderFloat("Ambient Rate", &particleSystem->ambientRate, 0.0f, 60000.0f, "%.0f / s");
+		ImGui::Checkbox("Particle frustum culling", &particleSystem->frustumCull);
+
 		ImGui::SeparatorText("Depth of Field");
 		ImGui::SliderFloat("Focus Distance", &state.focusDist, 1.0f, 1000.0f);
 		ImGui::SliderFloat("Focus Range", &state.focusRange, 0.1f, 1000.0f);
+		ImGui::Text("GPU: %.2f ms", post.dof.timer.getMs());
 
 		ImGui::SeparatorText("Bloom");
 		ImGui::SliderFloat("Threshold", &state.bloomThreshold, 0.1f, 5.0f);
 		ImGui::SliderFloat("Soft Knee", &state.bloomSoftKnee, 0.1f, 1.0f);
 		ImGui::SliderFloat("Intensity", &state.bloomIntensity, 0.0f, 3.0f);
+		ImGui::Text("GPU: down %.2f, up %.2f, composite %.2f ms", post.bloom.downTimer.getMs(), post.bloom.upTimer.getMs(), post.getCompositeMs());
 		
 		ImGui::SeparatorText("Color");
 		ImGui::SliderFloat("Saturation", &state.saturation, 0.0f, 2.5f);
@@ -327,6 +556,8 @@ public:
 		if (controlMode == ControlMode::Freecam && x < WINDOW_WIDTH - GUI_WIDTH) camera->rotate(x, y);
 	}
 
+	void setFirstFrameTime(float t) { firstFrameTime = t; }
+
 	void setCameraFirstMouse() {
 		if (controlMode == ControlMode::Freecam) camera->setFirstMouse();
 	}
@@ -344,14 +575,19 @@ public:
 
 		if (resources.terrainShader) { delete resources.terrainShader; resources.terrainShader = nullptr; }
 		if (resources.waterShader) { delete resources.waterShader; resources.waterShader = nullptr; }
+		if (resources.waterSurfaceShader) { delete resources.waterSurfaceShader; resources.waterSurfaceShader = nullptr; }
 		if (resources.instanceShader) { delete resources.instanceShader; resources.instanceShader = nullptr; }
+		if (resources.treeImpostorShader) { delete resources.treeImpostorShader; resources.treeImpostorShader = nullptr; }
+		if (resources.treeImpostors) { resources.treeImpostors->destroy(); delete resources.treeImpostors; resources.treeImpostors = nullptr; }
+		if (resources.culler) { delete resources.culler; resources.culler = nullptr; }
 
 		if (resources.marchingCubesCS) { delete resources.marchingCubesCS; resources.marchingCubesCS = nullptr; }
 		if (resources.groundDistanceCS) { delete resources.groundDistanceCS; resources.groundDistanceCS = nullptr; }
-		if (resources.terrainHeightCS) { delete resources.terrainHeightCS; resources.terrainHeightCS = nullptr; }
+		if (resources.treeScatterCS) { delete resources.treeScatterCS; resources.treeScatterCS = nullptr; }
 
 		post.destroy();
 		sceneTarget.destroy();
-		reflection.destroy();
+		waterSSR.destroy();
+		stream.destroy();
 	}
 };
\ No newline at end of file
@@ -8,6 +8,8 @@
 
 class Shader {
 	unsigned int shaderProgramId = 0;
+	unsigned int depthProgramId = 0;  // optional depth-only variant (shadow pass, depth prepass)
+	unsigned int activeProgramId = 0; // program the uniforms below go to
 	unsigned int vertexShader = 0, geometryShader = 0, fragmentShader = 0;
 
 	std::string readShaderCodeFromFile(const std::string& filePath) {
@@ -25,9 +27,17 @@ class Shader {
 		return shaderStream.str();
 	}
 
+	// Insert #defines right after the #version line
+	std::string withDefines(const std::string& code, const std::string& defines) {
+		if (defines.empty()) return code;
+		size_t eol = code.find('\n');
+		if (eol == std::string::npos) return code;
+		return code.substr(0, eol + 1) + defines + code.substr(eol + 1);
+	}
+
 	// get the address of a GPU uniform variable
 	int getLocation(const std::string& name) {
-		int location = glGetUniformLocation(shaderProgramId, name.c_str());
+		int location = glGetUniformLocation(activeProgramId, name.c_str());
 		if (location < 0) printf("uniform %s cannot be set\n", name.c_str());
 		return location;
 	}
@@ -79,15 +89,54 @@ public:
 		// Link shader program
 		glBindFragDataLocation(shaderProgramId, 0, fragmentShaderOutputName.c_str());
 		glLinkProgram(shaderProgramId);
+		activeProgramId = shaderProgramId;
+
+		return true;
+	}
 
+	// Same vertex shader compiled with DEPTH_ONLY, paired with a fragment shader that writes no color.
+	// The depth prepass relies on both programs producing identical depth, so opaque vertex shaders
+	// declare gl_Position invariant.
+	bool createDepthOnly(const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath = "depth.frag") {
+		const std::string defines = "#define DEPTH_ONLY\n";
+
+		std::string vertexShaderCode = withDefines(readShaderCodeFromFile(vertexShaderFilePath), defines);
+		const char* vertexSource = vertexShaderCode.c_str();
+		unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vs, 1, &vertexSource, NULL);
+		glCompileShader(vs);
+
+		std::string fragmentShaderCode = withDefines(readShaderCodeFromFile(fragmentShaderFilePath), defines);
+		const char* fragmentSource = fragmentShaderCode.c_str();
+		unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(fs, 1, &fragmentSource, NULL);
+		glCompileShader(fs);
+
+		depthProgramId = glCreateProgram();
+		glAttachShader(depthProgramId, vs);
+		glAttachShader(depthProgramId, fs);
+		glLinkProgram(depthProgramId);
+
+		// The program keeps the compiled code
+		glDeleteShader(vs);
+		glDeleteShader(fs);
 		return true;
 	}
 
 
 	void Use() {
+		activeProgramId = shaderProgramId;
 		glUseProgram(shaderProgramId);	// make this program run
 	}
 
+	// Falls back to the full program when there is no depth-only variant
+	void Use(bool depthOnly) {
+		activeProgramId = (depthOnly && depthProgramId) ? depthProgramId : shaderProgramId;
+		glUseProgram(activeProgramId);
+	}
+
+	bool hasDepthOnly() const { return depthProgramId != 0; }
+
 	void setUniform(int i, const std::string& name) {
 		int location = getLocation(name);
 		if (location >= 0) glUniform1i(location, i);
@@ -118,5 +167,21 @@ public:
 		if (location >= 0) glUniformMatrix4fv(location, 1, GL_FALSE, mat);
 	}
 
-	~Shader() { if (shaderProgramId > 0) glDeleteProgram(shaderProgramId); }
+	void setUniform(const mat4* mats, int count, const std::string& name) {
+		int location = getLocation(name);
+		if (location >= 0) glUniformMatrix4fv(location, count, GL_FALSE, mats[0]);
+	}
+
+	// Cascaded shadow lookup shared by every lit shader
+	void setShadowUniforms(const RenderState& state) {
+		setUniform(state.cascadeVP, SHADOW_CASCADES, "u_cascadeVP");
+		setUniform(state.cascadeSplits, "u_cascadeSplits");
+		setUniform(state.shadowTexel, "u_shadowTexel");
+		setUniform(state.shadowBias, "u_shadowBias");
+	}
+
+	~Shader() {
+		if (shaderProgramId > 0) glDeleteProgram(shaderProgramId);
+		if (depthProgramId > 0) glDeleteProgram(depthProgramId);
+	}
 };
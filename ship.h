@@ -1,6 +1,7 @@
 #pragma once
 #include "geometry.h"
 #include "MeshGenerator.h"
+#include "MeshSimplifier.h"
 
 class ShipGeometry : public Geometry {
 	float scale = 1.0f;
@@ -8,10 +9,12 @@ class ShipGeometry : public Geometry {
 	
 public:
 	ShipGeometry(float scale, int tesselation) : scale(scale), tesselation(tesselation) {
-		SdfMeshGenerator meshGen(tesselation, scale, [this](vec3 p) { return this->sdf(p); });
-		std::vector<vec3> vtxData;
-		meshGen.generate(vtxData);
-		init(vtxData); // upload to GPU
+		auto meshGen = makeSdfMeshGenerator(tesselation, scale, [this](vec3 p) { return this->sdf(p); });
+		IndexedMesh mesh;
+		meshGen.generate(mesh.vtx, mesh.idx);
+		std::vector<IndexedMesh> lods = buildLods(mesh, 4);
+		printLodTriangles("Ship", lods);
+		init(lods); // upload to GPU
 	}
 
     float sdf(vec3 p) {
@@ -9,7 +9,7 @@ uniform mat4 u_M, u_MVP;
 out vec3 viewDir_WS;
 
 void main() {
-	gl_Position = u_MVP * vec4(vtxPos_OS, 1.0);
+	gl_Position = (u_MVP * vec4(vtxPos_OS, 1.0)).xyww; // depth 1.0, on the far plane
 	vec4 vtxPos_WS = u_M * vec4(vtxPos_OS, 1);
 	viewDir_WS  = u_camPos_WS - vtxPos_WS.xyz;
 }
\ No newline at end of file
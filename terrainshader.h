@@ -9,18 +9,19 @@ class TerrainShader : public Shader {
 public:
 	TerrainShader() {
 		create("terrainshader.vert", "terrainshader.frag", "fragmentColor");
+		createDepthOnly("terrainshader.vert");
 	}
 
 	void Bind(RenderState state) {
-		Use();
+		Use(state.depthOnly);
 
-		setUniform(state.cameraPos, "u_camPos_WS");
 		setUniform(state.V, "u_V");
 		setUniform(state.P, "u_P");
+		if (state.depthOnly) return;
+
+		setUniform(state.cameraPos, "u_camPos_WS");
 
 		// Shadow
-		setUniform(state.lightVP, "u_lightVP");
-		setUniform(state.shadowTexel, "u_shadowTexel");
-		setUniform(state.shadowBias, "u_shadowBias");
+		setShadowUniforms(state);
 	}
 };
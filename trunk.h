@@ -1,22 +1,31 @@
 #pragma once
 #include "geometry.h"
 #include "MeshGenerator.h"
+#include "MeshSimplifier.h"
 #include "TreeParams.h"
 
 class TrunkGeometry : public Geometry {
-    float scale = 1.0f;
-    int tesselation = 32;
-    TreeParams params;
-
 public:
-    TrunkGeometry(float scale, int tesselation, const TreeParams& params) : scale(scale), tesselation(tesselation), params(params) {
-        SdfMeshGenerator meshGen(tesselation, scale, [this](vec3 p) { return this->sdf(p); });
-        std::vector<vec3> vtxData;
-        meshGen.generate(vtxData);
-        init(vtxData); // upload to GPU
+    static constexpr int LOD_COUNT = 4;
+
+    TrunkGeometry(float scale, int tesselation, const TreeParams& params) {
+        IndexedMesh mesh;
+        generate(scale, tesselation, params, mesh.vtx, mesh.idx);
+        init(buildLods(mesh, LOD_COUNT)); // upload to GPU
+    }
+
+    // Prebuilt LODs (e.g. from the mesh cache)
+    TrunkGeometry(const std::vector<IndexedMesh>& lods) {
+        init(lods);
+    }
+
+    // CPU only, safe to call from worker threads
+    static void generate(float scale, int tesselation, const TreeParams& params, std::vector<vec3>& vtxData, std::vector<uint32_t>& idxData, int threads = 1) {
+        auto meshGen = makeSdfMeshGenerator(tesselation, scale, [&params](vec3 p) { return sdf(params, p); }, threads);
+        meshGen.generate(vtxData, idxData);
     }
 
-    float sdf(vec3 p) {
+    static float sdf(const TreeParams& params, vec3 p) {
         float trunk = sdCapsule(p, params.trunkStartPos, params.trunkEndPos, params.trunkRadius);
         float branch1 = sdCapsule(p, params.branch1StartPos, params.branch1EndPos, params.branchRadius);
         float branch2 = sdCapsule(p, params.branch2StartPos, params.branch2EndPos, params.branchRadius);
@@ -25,14 +34,14 @@ public:
         return trunk + displace(p);
     }
 
-    float sdCapsule(vec3 p, vec3 a, vec3 b, float r) {
+    static float sdCapsule(vec3 p, vec3 a, vec3 b, float r) {
         vec3 pa = p - a, ba = b - a;
         float h = dot(pa, ba) / dot(ba, ba);
         clamp(h, 0.0f, 1.0f);
         return length(pa - ba * h) - r;
     }
 
-    float displace(vec3 p) {
+    static float displace(vec3 p) {
         float baseFreq = 0.16f;
         float baseAmpl = 1.0f;
         float warpFreq = 0.15f;
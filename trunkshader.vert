@@ -2,21 +2,40 @@
 precision highp float;
 
 layout(location=0) in vec3 vtxPos_OS;
-layout(location=1) in mat4 instM;
+layout(location=1) in vec3 instPos_WS;
+layout(location=2) in uint instYawScale; // packHalf2x16(yaw, scale)
 
 uniform vec3 u_camPos_WS;
 uniform mat4 u_V, u_P;
-uniform mat4 u_lightVP;
 
+invariant gl_Position;
+#ifndef DEPTH_ONLY
 out float viewDist_WS;
 out vec3 viewDir_WS;
-out vec4 lightPos_CS;
+out vec3 shadowPos_WS;
+#endif
+
+// Translate * RotateY(yaw) * Scale, column-major
+mat4 instanceMatrix() {
+    vec2 yawScale = unpackHalf2x16(instYawScale);
+    float c = cos(yawScale.x) * yawScale.y;
+    float s = sin(yawScale.x) * yawScale.y;
+    return mat4(
+        vec4(  c,         0.0,  -s, 0.0),
+        vec4(0.0, yawScale.y, 0.0, 0.0),
+        vec4(  s,         0.0,   c, 0.0),
+        vec4(instPos_WS,          1.0)
+    );
+}
 
 void main() {
+    mat4 instM = instanceMatrix();
     vec4 vtxPos_WS = instM * vec4(vtxPos_OS, 1.0);
     gl_Position = u_P * u_V * vtxPos_WS;
 
+#ifndef DEPTH_ONLY
     viewDir_WS  = u_camPos_WS - vtxPos_WS.xyz;
     viewDist_WS = length(viewDir_WS);
-    lightPos_CS = u_lightVP * vtxPos_WS;
+    shadowPos_WS = vtxPos_WS.xyz;
+#endif
 }
\ No newline at end of file
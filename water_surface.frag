@@ -0,0 +1,26 @@
+#version 450 core
+precision highp float;
+
+// Half-resolution water surface for the SSR trace: view-space normal and view-space depth.
+// The target is cleared to 0, which the trace reads as "no water" (view z is always negative).
+layout(binding = 7) uniform sampler2D u_hiZ; // RG = nearest, farthest depth; level 0 is this target's size
+uniform mat4 u_V;
+
+in vec3 vtxPos_VS;
+in vec3 viewDir_WS;
+
+out vec4 fragmentColor;
+
+// ---------- Main ----------
+void main() {
+    // Behind every opaque surface of the 2x2 block: never visible
+    if (gl_FragCoord.z > texelFetch(u_hiZ, ivec2(gl_FragCoord.xy), 0).g) discard;
+
+    // Same faceted normal as watershader.frag
+    vec3 xTangent = dFdx(viewDir_WS);
+    vec3 yTangent = dFdy(viewDir_WS);
+    vec3 N = normalize(cross(xTangent, yTangent));
+    vec3 N_VS = normalize((u_V * vec4(N, 0.0)).xyz);
+
+    fragmentColor = vec4(N_VS, vtxPos_VS.z);
+}
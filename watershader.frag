@@ -31,9 +31,12 @@ layout(std140, binding = 7) uniform ColorPalette {
     float u_fogDensity;
 };
 
-layout(binding = 2) uniform sampler2D u_shadowMap;
-layout(binding = 3) uniform sampler2D u_sceneColor;
-layout(binding = 4) uniform sampler2D u_sceneDepth;
+#define SHADOW_CASCADES 4
+layout(binding = 2) uniform sampler2DArray u_shadowMap;
+uniform mat4 u_cascadeVP[SHADOW_CASCADES];
+uniform vec4 u_cascadeSplits;
+layout(binding = 4) uniform sampler2D u_sceneDepth;  // opaque depth, still attached; the color pass does not write depth
+layout(binding = 5) uniform sampler2D u_ssr;         // half-res resolved reflection, confidence in .a
 uniform float     u_shadowBias;
 uniform vec2      u_shadowTexel;
 uniform mat4      u_V, u_P;
@@ -42,33 +45,40 @@ uniform mat4      u_invP;
 in float viewDist_WS;
 in vec3 vtxPos_VS;
 in vec3 viewDir_WS;
-in vec4 lightPos_CS;
+in vec3 vtxPos_WS;
 
 out vec4 fragmentColor;
 
 // ---------- Shadow ----------
-float shadowMask(vec4 lightClip) {
-    // Clip to NDC
-    vec3 proj = lightClip.xyz / lightClip.w;
-    vec2 uv = proj.xy * 0.5 + 0.5;
-    float depth = proj.z * 0.5 + 0.5;
-
-    // Outside map
-    if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) return 1.0;
-
-    // 3x3 PCF
-    float vis = 0.0;
-    int kernel = 1;
-    for (int dx = -kernel; dx <= kernel; ++dx) {
-        for (int dy = -kernel; dy <= kernel; ++dy) {
-            vec2 offset = vec2(dx, dy) * u_shadowTexel;
-            float closest = texture(u_shadowMap, uv + offset).r;
-            float current = depth - u_shadowBias;
-            vis += (current <= closest) ? 1.0 : 0.0;
+float shadowMask(vec3 pos_WS, float viewDist) {
+    // First cascade whose range covers the fragment; a cascade still waiting for its refresh falls through to the next
+    for (int c = 0; c < SHADOW_CASCADES; c++) {
+        if (viewDist > u_cascadeSplits[c]) continue;
+
+        // World to light NDC
+        vec4 lightClip = u_cascadeVP[c] * vec4(pos_WS, 1.0);
+        vec3 proj = lightClip.xyz / lightClip.w;
+        vec2 uv = proj.xy * 0.5 + 0.5;
+        float depth = proj.z * 0.5 + 0.5;
+
+        // Outside map
+        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) continue;
+
+        // 3x3 PCF
+        float vis = 0.0;
+        int kernel = 1;
+        for (int dx = -kernel; dx <= kernel; ++dx) {
+            for (int dy = -kernel; dy <= kernel; ++dy) {
+                vec2 offset = vec2(dx, dy) * u_shadowTexel;
+                float closest = texture(u_shadowMap, vec3(uv + offset, float(c))).r;
+                float current = depth - u_shadowBias;
+                vis += (current <= closest) ? 1.0 : 0.0;
+            }
         }
-    }
 
-    return vis / pow(kernel * 2 + 1, 2);
+        return vis / pow(kernel * 2 + 1, 2);
+    }
+    return 1.0;
 }
 
 // ---------- SSR ----------
@@ -80,36 +90,6 @@ vec3 viewFromDepth(vec2 uv, float depth01) {
     return vs.xyz / vs.w;
 }
 
-// Returns uv of hit and weight (hit? 1:0)
-vec3 ssrTrace(vec3 originVS, vec3 dirVS) {
-    const int   STEPS = 100;
-    const float STEP  = 5.0;
-    const float THICK = 10.0;   // thickness tolerance
-    vec3 p = originVS;
-
-    for (int i=0; i<STEPS; ++i) {
-        p += dirVS * STEP;
-
-        // project to screen
-        vec4 clip = u_P * vec4(p, 1.0);
-        vec3 ndc  = clip.xyz / clip.w;
-        vec2 uv   = ndc.xy * 0.5 + 0.5;
-
-        // out of screen
-        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) break;
-
-        float sceneDepth01 = texture(u_sceneDepth, uv).r;
-        vec3  sceneVS      = viewFromDepth(uv, sceneDepth01);
-
-        // ray vs depth plane test (both are in VS; z is negative forward)
-        if (p.z >= sceneVS.z - THICK && p.z <= sceneVS.z + THICK) {
-            return vec3(uv, 1.0);
-        }
-    }
-
-    return vec3(0.0, 0.0, 0.0);
-}
-
 // ---------- Water Depth ----------
 float getWaterDepth() {
     vec2 screenUV = gl_FragCoord.xy / vec2(textureSize(u_sceneDepth, 0));
@@ -146,26 +126,17 @@ void main() {
 	vec3 diffuse = material.kd.xyz * texColor * NdotL * u_lightLe.xyz;
 	vec3 specular = material.ks.xyz * spec * u_lightLe.xyz;
 
-    float shadow = shadowMask(lightPos_CS);
+    float shadow = shadowMask(vtxPos_WS, viewDist_WS);
     vec3 radiance = ambient + (diffuse + specular) * shadow;
 
     // Base sky gradient
     float t = clamp(V.y * 0.5 + 0.5, 0.0, 1.0);
     vec4 skyCol = mix(u_skyColor, u_atmosphereColor, t);
 
-    // Build reflection ray in view space
-    vec3 N_VS = normalize((u_V * vec4(N, 0.0)).xyz);
-    vec3 viewDir_VS = normalize(-vtxPos_VS);              // camera at origin in VS
-    vec3 reflection_VS  = reflect(-viewDir_VS, N_VS);
-
-    // start just above the surface to avoid self-hits
-    vec3 start = vtxPos_VS + N_VS * 0.05;
-    vec3 hit = ssrTrace(start, reflection_VS);
-
-    vec3 reflColor = skyCol.xyz;                 // fallback
-    if (hit.z > 0.5) {
-        reflColor = texture(u_sceneColor, hit.xy).rgb;
-    }
+    // Traced reflection where it found a hit, sky elsewhere
+    vec2 screenUV = gl_FragCoord.xy / vec2(textureSize(u_sceneDepth, 0));
+    vec4 ssr = texture(u_ssr, screenUV);
+    vec3 reflColor = mix(skyCol.xyz, ssr.rgb, clamp(ssr.a, 0.0, 1.0));
 
     // Schlick's approximation
     float R0 = 0.02;
@@ -3,26 +3,47 @@
 #include "shader.h"
 #include "renderstate.h"
 
+// Half the cells per side of every water clipmap level; matches RING_CELLS in watershader.vert
+constexpr int WATER_RING_CELLS = 32;
+
 class WaterShader : public Shader {
 public:
 	WaterShader() {
 		create("watershader.vert", "watershader.frag", "fragmentColor");
+		createDepthOnly("watershader.vert");
 	}
 
 	void Bind(RenderState state) {
-		Use();
+		Use(state.depthOnly);
 
 		setUniform(state.time, "u_time");
-		vec2 originXZ = vec2(floor(state.cameraPos.x / state.chunkSize), floor(state.cameraPos.z / state.chunkSize)) * state.chunkSize + vec2(state.chunkSize / 2.0f, state.chunkSize / 2.0f);
-		setUniform(originXZ, "u_planeOriginXZ");
+		setUniform(state.waterCell, "u_waterCell");
 		setUniform(state.V, "u_V");
 		setUniform(state.P, "u_P");
-		setUniform(state.invP, "u_invP");
 		setUniform(state.cameraPos, "u_camPos_WS");
+		if (state.depthOnly) return;
+
+		setUniform(state.invP, "u_invP");
 
 		// Shadow
-		setUniform(state.lightVP, "u_lightVP");
-		setUniform(state.shadowTexel, "u_shadowTexel");
-		setUniform(state.shadowBias, "u_shadowBias");
+		setShadowUniforms(state);
+	}
+};
+
+// Half-resolution water normals and depth for the SSR trace
+class WaterSurfaceShader : public Shader {
+public:
+	WaterSurfaceShader() {
+		create("watershader.vert", "water_surface.frag", "fragmentColor");
+	}
+
+	void Bind(RenderState state) {
+		Use();
+
+		setUniform(state.time, "u_time");
+		setUniform(state.waterCell, "u_waterCell");
+		setUniform(state.V, "u_V");
+		setUniform(state.P, "u_P");
+		setUniform(state.cameraPos, "u_camPos_WS");
 	}
 };
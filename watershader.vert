@@ -23,17 +23,17 @@ layout(std140, binding = 3) uniform TerrainParams {
     float u_waterLevel;
 };
 
+#define RING_CELLS 32 // matches WATER_RING_CELLS in watershader.h
+
 uniform float u_time;
-uniform vec2 u_planeOriginXZ;
+uniform float u_waterCell;  // cell size of the finest clipmap level
 uniform vec3 u_camPos_WS;
 uniform mat4 u_V, u_P;
-uniform mat4 u_lightVP;
 
 out float viewDist_WS;
 out vec3 viewDir_WS;
 out vec3 vtxPos_WS;
 out vec3 vtxPos_VS;
-out vec4 lightPos_CS;
 
 // ---------- Seed ----------
 vec3 seedOffset(int s) {
@@ -97,16 +97,46 @@ float fbmSimplex3D(vec3 p, float freq, float amp, float fMul, float aMul, int oc
     return acc;
 }
 
+float waveHeight(vec2 xz) {
+	return fbmSimplex3D(vec3(xz.x, u_time * 10.0, xz.y), 0.02, 1.0, 2.0, 0.5, 2);
+}
+
 // ---------- Main ----------
 void main() {
-	vtxPos_WS = vertexPos + vec3(u_planeOriginXZ.x, u_waterLevel, u_planeOriginXZ.y);
-	vtxPos_WS.y += fbmSimplex3D(vec3(vtxPos_WS.x, u_time * 10.0, vtxPos_WS.z), 0.02, 1.0, 2.0, 0.5, 2);
+	// Clipmap vertex: cells of its level in xz, level and trim category packed in y (see ClipmapGeometry)
+	int code = int(vertexPos.y + 0.5);
+	int level = code & 15;
+	int trim = code >> 4;
+	float cell = u_waterCell * exp2(float(level));
+	vec2 origin = floor(u_camPos_WS.xz / (2.0 * cell)) * 2.0 * cell;
+
+	// Trim cell the finer level covers: collapse it outside the clip volume
+	if (trim > 0) {
+		vec2 finerOrigin = floor(u_camPos_WS.xz / cell) * cell;
+		bvec2 movedUp = greaterThan(finerOrigin - origin, vec2(0.5 * cell));
+		ivec2 c = ivec2(trim % 3, trim / 3);
+		bool coveredX = c.x == 0 || (c.x == 1 && !movedUp.x) || (c.x == 2 && movedUp.x);
+		bool coveredZ = c.y == 0 || (c.y == 1 && !movedUp.y) || (c.y == 2 && movedUp.y);
+		if (coveredX && coveredZ) {
+			gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+			return;
+		}
+	}
+
+	vtxPos_WS = vec3(origin.x + vertexPos.x * cell, u_waterLevel, origin.y + vertexPos.z * cell);
+
+	// Odd vertices on the outer border sit mid-edge of the next level: take its interpolated height, no cracks
+	vec2 k = vertexPos.xz;
+	vec2 along = vec2(0.0);
+	if (abs(k.x) == float(RING_CELLS) && mod(k.y, 2.0) != 0.0) along = vec2(0.0, cell);
+	if (abs(k.y) == float(RING_CELLS) && mod(k.x, 2.0) != 0.0) along = vec2(cell, 0.0);
+	if (along != vec2(0.0)) vtxPos_WS.y += 0.5 * (waveHeight(vtxPos_WS.xz - along) + waveHeight(vtxPos_WS.xz + along));
+	else vtxPos_WS.y += waveHeight(vtxPos_WS.xz);
 
 	vec4 vtxPos_CS = u_P * u_V * vec4(vtxPos_WS, 1.0);
 	gl_Position = vtxPos_CS;
 
 	viewDir_WS  = u_camPos_WS - vtxPos_WS.xyz;
 	viewDist_WS = length(viewDir_WS);         // Distance from eye to vertex
-	lightPos_CS = u_lightVP * vec4(vtxPos_WS, 1.0);
 	vtxPos_VS = (u_V * vec4(vtxPos_WS, 1.0)).xyz;
 }
\ No newline at end of file